@@ -0,0 +1,1133 @@
+#include "Benchmark.h"
+
+#define BENCHMARK_FILENAME L"/benchmark.txt"
+#define DETERMINISM_FILENAME L"/determinism.txt"
+#define GOLDEN_HASHES_FILENAME L"/Assets/DeterminismHashes.txt"
+
+void PointCloudEngine::Benchmark::Run(std::wstring plyfile)
+{
+    std::wofstream output(executableDirectory + BENCHMARK_FILENAME);
+    PointBuffer points;
+
+    output << L"# Benchmark of " << plyfile << std::endl;
+
+    if (!LoadPlyFile(points, plyfile))
+    {
+        output << L"Could not open " << plyfile << std::endl;
+        return;
+    }
+
+    output << L"Points: " << points.GetCount() << std::endl;
+    output << L"Hardware Threads: " << std::thread::hardware_concurrency() << std::endl;
+    output << std::endl;
+
+    PlyLoading(output, plyfile);
+    OctreeBuildScaling(output, points);
+    OctreeBuilderComparison(output, points);
+    SubdivisionModeComparison(output, points);
+    OctreeTraversal(output, points);
+    ClusteringModeComparison(output, points);
+    ClusteringIterations(output, points);
+    KMeansKernels(output, points);
+    NormalEncoding(output, points);
+    ColorEncoding(output, points);
+    NodeAllocation(output, points);
+    DynamicUpdates(output, points);
+    OctreeCacheLoad(output, points, plyfile);
+    StreamedTraversal(output, plyfile);
+    OutOfCoreBuild(output, points, plyfile);
+
+    output.flush();
+    output.close();
+}
+
+void PointCloudEngine::Benchmark::PlyLoading(std::wofstream &output, const std::wstring &plyfile)
+{
+    // The file was loaded right before, both loaders read it from the file cache of the operating system
+    PlyReader *reader = new PlyReader(plyfile);
+    double megabytes = reader->GetFileSize() / (1024.0 * 1024.0);
+    bool mapped = reader->IsValid();
+    bool columns = mapped && (reader->GetVertexCount() == 0);
+    SafeDelete(reader);
+
+    output << L"# Ply Loading (" << megabytes << L" MB, buildThreadCount=" << settings->buildThreadCount << L")" << std::endl;
+
+    if (!mapped)
+    {
+        output << L"Only binary little endian and ascii files with the vertex element first and .xyz/.pts files are loaded from the memory mapped file" << std::endl;
+        output << std::endl;
+        return;
+    }
+
+    output << L"Loader\tSeconds\tMB/s\tMatching Vertices" << std::endl;
+
+    // Tinyply cannot read column files
+    PointBuffer tinyplyPoints;
+
+    if (!columns)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        LoadPlyFileWithTinyply(tinyplyPoints, plyfile);
+        double tinyplySeconds = GetElapsedSeconds(start);
+
+        output << L"Tinyply\t" << tinyplySeconds << L"\t" << (megabytes / tinyplySeconds) << L"\t-" << std::endl;
+    }
+
+    // Includes mapping the file and parsing the header
+    PointBuffer mappedPoints;
+    auto start = std::chrono::high_resolution_clock::now();
+    reader = new PlyReader(plyfile);
+    reader->ReadVertices(mappedPoints);
+    SafeDelete(reader);
+    double mappedSeconds = GetElapsedSeconds(start);
+
+    auto equalPoints = [](const PointBuffer &a, const PointBuffer &b)
+    {
+        size_t count = a.GetCount();
+
+        return (count == b.GetCount())
+            && std::equal(a.GetPositions(), a.GetPositions() + count, b.GetPositions())
+            && std::equal(a.GetNormals(), a.GetNormals() + count, b.GetNormals())
+            && std::equal(a.GetColors(), a.GetColors() + 3 * count, b.GetColors());
+    };
+
+    bool matching = equalPoints(tinyplyPoints, mappedPoints);
+
+    output << L"Memory Mapped\t" << mappedSeconds << L"\t" << (megabytes / mappedSeconds) << L"\t" << (columns ? L"-" : (matching ? L"Yes" : L"No")) << std::endl;
+
+    // Binary files can also be streamed in batches into the final array, the other memory is only the two staging buffers of the stream
+    PlyStream *stream = new PlyStream(plyfile);
+
+    if (stream->IsValid())
+    {
+        std::vector<Vertex> streamedVertices(stream->GetVertexCount());
+        size_t streamedCount = 0;
+
+        start = std::chrono::high_resolution_clock::now();
+
+        while (size_t count = stream->NextBatch(streamedVertices.data() + streamedCount, streamedVertices.size() - streamedCount))
+        {
+            streamedCount += count;
+        }
+
+        double streamedSeconds = GetElapsedSeconds(start);
+
+        PointBuffer streamedPoints;
+        streamedPoints.Resize(streamedCount);
+        streamedPoints.Deinterleave(0, streamedCount, streamedVertices.data());
+        matching = (streamedCount == streamedVertices.size()) && equalPoints(tinyplyPoints, streamedPoints);
+
+        output << L"Streamed\t" << streamedSeconds << L"\t" << (megabytes / streamedSeconds) << L"\t" << (matching ? L"Yes" : L"No") << std::endl;
+    }
+
+    SafeDelete(stream);
+    output << std::endl;
+}
+
+void PointCloudEngine::Benchmark::OctreeBuildScaling(std::wofstream &output, const PointBuffer &points)
+{
+    // Build the octree with 1, 2, 4, ... threads up to all hardware threads and compare to the single threaded build
+    int buildThreadCount = settings->buildThreadCount;
+    int hardwareThreads = max(1, (int)std::thread::hardware_concurrency());
+    double singleThreadSeconds = 0;
+
+    output << L"# Octree Build Scaling (maxOctreeDepth=" << settings->maxOctreeDepth << L", parallelBuildCutoff=" << settings->parallelBuildCutoff << L")" << std::endl;
+    output << L"Threads\tSeconds\tSpeedup" << std::endl;
+
+    for (int threads = 1; threads <= hardwareThreads; threads = (threads == hardwareThreads) ? threads + 1 : min(2 * threads, hardwareThreads))
+    {
+        settings->buildThreadCount = threads;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        Octree *octree = new Octree(points, settings->maxOctreeDepth);
+        double seconds = GetElapsedSeconds(start);
+        SafeDelete(octree);
+
+        if (threads == 1)
+        {
+            singleThreadSeconds = seconds;
+        }
+
+        output << threads << L"\t" << seconds << L"\t" << (singleThreadSeconds / seconds) << std::endl;
+    }
+
+    output << std::endl;
+
+    // Restore the value from the settings file
+    settings->buildThreadCount = buildThreadCount;
+}
+
+void PointCloudEngine::Benchmark::OctreeBuilderComparison(std::wofstream &output, const PointBuffer &points)
+{
+    OctreeBuilder octreeBuilder = settings->octreeBuilder;
+
+    output << L"# Octree Builder Comparison (maxOctreeDepth=" << settings->maxOctreeDepth << L", buildThreadCount=" << settings->buildThreadCount << L")" << std::endl;
+    output << L"Builder\tSeconds" << std::endl;
+
+    OctreeBuilder builders[2] = { OctreeBuilder::TopDown, OctreeBuilder::Morton };
+    std::wstring builderNames[2] = { L"TopDown", L"Morton" };
+
+    for (int i = 0; i < 2; i++)
+    {
+        settings->octreeBuilder = builders[i];
+
+        auto start = std::chrono::high_resolution_clock::now();
+        Octree *octree = new Octree(points, settings->maxOctreeDepth);
+        double seconds = GetElapsedSeconds(start);
+        SafeDelete(octree);
+
+        output << builderNames[i] << L"\t" << seconds << std::endl;
+    }
+
+    output << std::endl;
+
+    settings->octreeBuilder = octreeBuilder;
+}
+
+void PointCloudEngine::Benchmark::SubdivisionModeComparison(std::wofstream &output, const PointBuffer &points)
+{
+    SubdivisionMode subdivisionMode = settings->subdivisionMode;
+
+    output << L"# Subdivision Mode Comparison (maxOctreeDepth=" << settings->maxOctreeDepth << L", maxLeafVertexCount=" << settings->maxLeafVertexCount << L", minNodeSize=" << settings->minNodeSize << L")" << std::endl;
+    output << L"Mode\tSeconds\tNodes\tLevels\tTraversal Vertices\tTraversal Milliseconds" << std::endl;
+
+    SubdivisionMode modes[2] = { SubdivisionMode::FixedDepth, SubdivisionMode::Adaptive };
+    std::wstring modeNames[2] = { L"FixedDepth", L"Adaptive" };
+
+    for (int i = 0; i < 2; i++)
+    {
+        settings->subdivisionMode = modes[i];
+
+        auto start = std::chrono::high_resolution_clock::now();
+        Octree *octree = new Octree(points, settings->maxOctreeDepth);
+        double seconds = GetElapsedSeconds(start);
+
+        // Traverse from a camera close to the root cube to include the leaves of the dense regions
+        Vector3 rootPosition;
+        float rootSize;
+        octree->GetRootPositionAndSize(rootPosition, rootSize);
+
+        std::vector<OctreeNodeVertex> traversalVertices;
+
+        start = std::chrono::high_resolution_clock::now();
+        octree->GetVertices(rootPosition - rootSize * Vector3::UnitZ, ViewFrustum(), 0.01f, traversalVertices);
+        double traversalSeconds = GetElapsedSeconds(start);
+        size_t traversalVertexCount = traversalVertices.size();
+
+        output << modeNames[i] << L"\t" << seconds << L"\t" << octree->GetNodeCount() << L"\t" << octree->GetClusteringStatistics().size() << L"\t" << traversalVertexCount << L"\t" << (1000.0 * traversalSeconds) << std::endl;
+        SafeDelete(octree);
+    }
+
+    output << std::endl;
+
+    settings->subdivisionMode = subdivisionMode;
+}
+
+void PointCloudEngine::Benchmark::OctreeTraversal(std::wofstream &output, const PointBuffer &points)
+{
+    Octree *octree = new Octree(points, settings->maxOctreeDepth);
+    size_t nodeCount = octree->GetNodeCount();
+
+    // The linked nodes are what the octree stored before, each of them was a separate heap allocation
+    output << L"# Octree Node Memory" << std::endl;
+    output << L"Nodes: " << nodeCount << std::endl;
+    output << L"Flat Node Array: " << (nodeCount * sizeof(FlatOctreeNode)) / (1024.0 * 1024.0) << L" MB (" << sizeof(FlatOctreeNode) << L" bytes per node)" << std::endl;
+    output << L"Flat Node Array With Positions: " << (nodeCount * (sizeof(OctreeNodeVertex) + 2 * sizeof(UINT32))) / (1024.0 * 1024.0) << L" MB (" << (sizeof(OctreeNodeVertex) + 2 * sizeof(UINT32)) << L" bytes per node)" << std::endl;
+    output << L"Linked Nodes: " << (nodeCount * sizeof(OctreeNode)) / (1024.0 * 1024.0) << L" MB (" << sizeof(OctreeNode) << L" bytes per node without heap overhead)" << std::endl;
+    output << std::endl;
+
+    // Traverse from different camera distances in front of the root cube, closer cameras produce larger cuts
+    Vector3 rootPosition;
+    float rootSize;
+    octree->GetRootPositionAndSize(rootPosition, rootSize);
+
+    // A new buffer per frame grows from zero like the vector that the traversal returned before
+    // The reused buffer is filled once before the measurement, the reallocations count how often it moved during the measured frames
+    output << L"# Octree Traversal (splatSize=0.01)" << std::endl;
+    output << L"Camera Distance\tVertices\tNew Buffer Milliseconds\tReused Buffer Milliseconds\tReallocations" << std::endl;
+
+    const int repetitions = 10;
+    std::vector<OctreeNodeVertex> octreeVertices;
+
+    for (float distance = 0.5f; distance <= 8.0f; distance *= 2)
+    {
+        Vector3 localCameraPosition = rootPosition - distance * rootSize * Vector3::UnitZ;
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for (int i = 0; i < repetitions; i++)
+        {
+            std::vector<OctreeNodeVertex> frameVertices;
+            octree->GetVertices(localCameraPosition, ViewFrustum(), 0.01f, frameVertices);
+        }
+
+        double newBufferSeconds = GetElapsedSeconds(start) / repetitions;
+
+        octree->GetVertices(localCameraPosition, ViewFrustum(), 0.01f, octreeVertices);
+        const OctreeNodeVertex *data = octreeVertices.data();
+        int reallocations = 0;
+
+        start = std::chrono::high_resolution_clock::now();
+
+        for (int i = 0; i < repetitions; i++)
+        {
+            octree->GetVertices(localCameraPosition, ViewFrustum(), 0.01f, octreeVertices);
+            reallocations += (octreeVertices.data() != data) ? 1 : 0;
+            data = octreeVertices.data();
+        }
+
+        double reusedBufferSeconds = GetElapsedSeconds(start) / repetitions;
+
+        output << distance << L"\t" << octreeVertices.size() << L"\t" << (1000.0 * newBufferSeconds) << L"\t" << (1000.0 * reusedBufferSeconds) << L"\t" << reallocations << std::endl;
+    }
+
+    output << std::endl;
+    output << L"Level\tVertices\tMilliseconds" << std::endl;
+
+    for (int level = 0; level <= settings->maxOctreeDepth; level++)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for (int i = 0; i < repetitions; i++)
+        {
+            octree->GetVerticesAtLevel(level, octreeVertices);
+        }
+
+        output << level << L"\t" << octreeVertices.size() << L"\t" << (1000.0 * GetElapsedSeconds(start)) / repetitions << std::endl;
+    }
+
+    output << std::endl;
+
+    // Cameras inside and in front of the root cube look at its center with the projection of the window, the tables above don't cull
+    // Culling only removes nodes, the culled vertices have to be the vertices of the full cut in the same order without the ones outside of the frustum
+    Matrix projection = XMMatrixPerspectiveFovLH(settings->fovAngleY, (float)settings->resolutionX / (float)settings->resolutionY, settings->nearZ, settings->farZ);
+    std::vector<OctreeNodeVertex> culledVertices;
+
+    output << L"# Frustum Culling (splatSize=0.01, fovAngleY=" << settings->fovAngleY << L")" << std::endl;
+    output << L"Camera Distance\tVertices\tCulled Vertices\tVisible Fraction\tMilliseconds\tCulled Milliseconds\tMatching Visible Vertices" << std::endl;
+
+    for (float distance = 0.0f; distance <= 4.0f; distance = (distance == 0) ? 0.25f : 2 * distance)
+    {
+        Vector3 localCameraPosition = rootPosition - distance * rootSize * Vector3::UnitZ;
+        ViewFrustum frustum(Matrix(XMMatrixLookToLH(localCameraPosition, Vector3::UnitZ, Vector3::UnitY)) * projection);
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for (int i = 0; i < repetitions; i++)
+        {
+            octree->GetVertices(localCameraPosition, ViewFrustum(), 0.01f, octreeVertices);
+        }
+
+        double seconds = GetElapsedSeconds(start) / repetitions;
+        start = std::chrono::high_resolution_clock::now();
+
+        for (int i = 0; i < repetitions; i++)
+        {
+            octree->GetVertices(localCameraPosition, frustum, 0.01f, culledVertices);
+        }
+
+        double culledSeconds = GetElapsedSeconds(start) / repetitions;
+
+        // Every skipped vertex must have its center outside of the frustum
+        size_t culledIndex = 0;
+        bool matching = true;
+
+        for (auto it = octreeVertices.begin(); it != octreeVertices.end(); it++)
+        {
+            if ((culledIndex < culledVertices.size()) && (culledVertices[culledIndex].position == it->position) && (culledVertices[culledIndex].size == it->size))
+            {
+                culledIndex++;
+            }
+            else
+            {
+                int outsideMask, insideMask;
+                frustum.TestCubes(&it->position, 1, 0, outsideMask, insideMask);
+                matching &= (insideMask == 0);
+            }
+        }
+
+        matching &= (culledIndex == culledVertices.size());
+        double visibleFraction = octreeVertices.empty() ? 0 : (double)culledVertices.size() / octreeVertices.size();
+
+        output << distance << L"\t" << octreeVertices.size() << L"\t" << culledVertices.size() << L"\t" << visibleFraction << L"\t" << (1000.0 * seconds) << L"\t" << (1000.0 * culledSeconds) << L"\t" << (matching ? L"Yes" : L"No") << std::endl;
+    }
+
+    output << std::endl;
+
+    SafeDelete(octree);
+}
+
+void PointCloudEngine::Benchmark::ClusteringModeComparison(std::wofstream &output, const PointBuffer &points)
+{
+    ClusteringMode clusteringMode = settings->clusteringMode;
+
+    output << L"# Clustering Mode Comparison (maxOctreeDepth=" << settings->maxOctreeDepth << L", buildThreadCount=" << settings->buildThreadCount << L")" << std::endl;
+
+    // Both modes create the same nodes, only the clusters are different
+    settings->clusteringMode = ClusteringMode::PerNode;
+    auto start = std::chrono::high_resolution_clock::now();
+    Octree *perNodeOctree = new Octree(points, settings->maxOctreeDepth);
+    double perNodeSeconds = GetElapsedSeconds(start);
+
+    settings->clusteringMode = ClusteringMode::BottomUp;
+    start = std::chrono::high_resolution_clock::now();
+    Octree *bottomUpOctree = new Octree(points, settings->maxOctreeDepth);
+    double bottomUpSeconds = GetElapsedSeconds(start);
+
+    output << L"PerNode Seconds: " << perNodeSeconds << std::endl;
+    output << L"BottomUp Seconds: " << bottomUpSeconds << std::endl;
+
+    // Angle from each bottom up cluster normal to the closest per node cluster normal of the same node, weighted by the cluster weights
+    output << L"Level\tNodes\tMean Angular Error (Degrees)\tMax Angular Error (Degrees)" << std::endl;
+
+    std::vector<OctreeNodeVertex> perNodeVertices;
+    std::vector<OctreeNodeVertex> bottomUpVertices;
+
+    for (int level = 0; level <= settings->maxOctreeDepth; level++)
+    {
+        perNodeOctree->GetVerticesAtLevel(level, perNodeVertices);
+        bottomUpOctree->GetVerticesAtLevel(level, bottomUpVertices);
+
+        if (perNodeVertices.empty() || (perNodeVertices.size() != bottomUpVertices.size()))
+        {
+            break;
+        }
+
+        double errorSum = 0;
+        double weightSum = 0;
+        double maxError = 0;
+
+        for (size_t i = 0; i < perNodeVertices.size(); i++)
+        {
+            for (int j = 0; j < 6; j++)
+            {
+                if (bottomUpVertices[i].weights[j] > 0)
+                {
+                    Vector3 normal = bottomUpVertices[i].normals[j].ToVector3();
+                    double minAngle = XM_PI;
+
+                    for (int l = 0; l < 6; l++)
+                    {
+                        if (perNodeVertices[i].weights[l] > 0)
+                        {
+                            float cosAngle = max(-1.0f, min(1.0f, normal.Dot(perNodeVertices[i].normals[l].ToVector3())));
+                            minAngle = min(minAngle, acos(cosAngle));
+                        }
+                    }
+
+                    double angle = XMConvertToDegrees(minAngle);
+                    errorSum += bottomUpVertices[i].weights[j] * angle;
+                    weightSum += bottomUpVertices[i].weights[j];
+                    maxError = max(maxError, angle);
+                }
+            }
+        }
+
+        output << level << L"\t" << perNodeVertices.size() << L"\t" << (errorSum / max(weightSum, 1.0)) << L"\t" << maxError << std::endl;
+    }
+
+    output << std::endl;
+
+    SafeDelete(perNodeOctree);
+    SafeDelete(bottomUpOctree);
+
+    settings->clusteringMode = clusteringMode;
+}
+
+void PointCloudEngine::Benchmark::ClusteringIterations(std::wofstream &output, const PointBuffer &points)
+{
+    Octree *octree = new Octree(points, settings->maxOctreeDepth);
+    std::vector<ClusteringStatistics> clusteringStatistics = octree->GetClusteringStatistics();
+    SafeDelete(octree);
+
+    output << L"# Clustering Iterations (kMeansMaxIterations=" << settings->kMeansMaxIterations << L", kMeansTolerance=" << settings->kMeansTolerance << L")" << std::endl;
+    output << L"Level\tNodes\tAverage\tMaximum\tCapped Nodes" << std::endl;
+
+    for (int level = 0; level < clusteringStatistics.size(); level++)
+    {
+        const ClusteringStatistics &statistics = clusteringStatistics[level];
+        output << level << L"\t" << statistics.nodeCount << L"\t" << ((double)statistics.iterations / statistics.nodeCount) << L"\t" << statistics.maxIterations << L"\t" << statistics.cappedNodeCount << std::endl;
+    }
+
+    output << std::endl;
+}
+
+void PointCloudEngine::Benchmark::KMeansKernels(std::wofstream &output, const PointBuffer &points)
+{
+    // Cluster all the normals at once like the root node does with every kernel the processor supports
+    // The assignments of the SIMD kernels are compared to the scalar kernel which matches the original distance comparison
+    std::wstring kernelNames[3] = { L"Scalar", L"SSE2", L"AVX2" };
+    int supportedInstructionSet = KMeans::GetInstructionSet();
+
+    // The kernels cluster the normal array like inside the nodes of the builders
+    size_t count = points.GetCount();
+    byte *scalarClusters = new byte[count];
+    byte *clusters = new byte[count];
+    Vector3 means[6];
+    int counts[6];
+
+    output << L"# K-Means Kernels" << std::endl;
+    output << L"Kernel\tIterations\tSeconds\tSpeedup\tMatching Assignments" << std::endl;
+
+    double scalarSeconds = 0;
+
+    for (int instructionSet = 0; instructionSet <= supportedInstructionSet; instructionSet++)
+    {
+        byte *outClusters = (instructionSet == 0) ? scalarClusters : clusters;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        int iterations = KMeans::ClusterNormals(points.GetNormals(), count, means, counts, outClusters, instructionSet);
+        double seconds = GetElapsedSeconds(start);
+
+        if (instructionSet == 0)
+        {
+            scalarSeconds = seconds;
+        }
+
+        bool matching = std::equal(scalarClusters, scalarClusters + count, outClusters);
+
+        output << kernelNames[instructionSet] << L"\t" << iterations << L"\t" << seconds << L"\t" << (scalarSeconds / seconds) << L"\t" << (matching ? L"Yes" : L"No") << std::endl;
+    }
+
+    output << std::endl;
+
+    delete[] scalarClusters;
+    delete[] clusters;
+}
+
+void PointCloudEngine::Benchmark::NormalEncoding(std::wofstream &output, const PointBuffer &points)
+{
+    // Encode and decode all the vertex normals, the angular error is measured against the normalized vertex normal
+    // The octahedral kernels are compared to the scalar kernel which creates the same bits as the octahedral normal constructor
+    std::wstring kernelNames[3] = { L"Octahedral Scalar", L"Octahedral SSE2", L"Octahedral AVX2" };
+    int supportedInstructionSet = KMeans::GetInstructionSet();
+    size_t count = points.GetCount();
+    const Vector3 *normals = points.GetNormals();
+
+    std::vector<Vector3> decodedNormals(count);
+    std::vector<PolarNormal> polarNormals(count);
+    std::vector<OctahedralNormal> scalarNormals(count);
+    std::vector<OctahedralNormal> octahedralNormals(count);
+
+    auto getErrors = [&](double &outMaxError, double &outMeanError)
+    {
+        outMaxError = 0;
+        outMeanError = 0;
+        size_t errorCount = 0;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            Vector3 normal = normals[i];
+
+            if (normal.LengthSquared() < FLT_EPSILON)
+            {
+                continue;
+            }
+
+            normal.Normalize();
+            float cosAngle = max(-1.0f, min(1.0f, normal.Dot(decodedNormals[i])));
+            double angle = XMConvertToDegrees(acos(cosAngle));
+
+            outMaxError = max(outMaxError, angle);
+            outMeanError += angle;
+            errorCount++;
+        }
+
+        outMeanError /= max(errorCount, (size_t)1);
+    };
+
+    output << L"# Normal Encoding (" << count << L" normals)" << std::endl;
+    output << L"Encoding\tEncode Seconds\tDecode Seconds\tMillion Normals/s Encoded\tMillion Normals/s Decoded\tMaximum Error (Degrees)\tMean Error (Degrees)\tMatching Scalar" << std::endl;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (size_t i = 0; i < count; i++)
+    {
+        polarNormals[i] = PolarNormal(normals[i]);
+    }
+
+    double encodeSeconds = GetElapsedSeconds(start);
+    start = std::chrono::high_resolution_clock::now();
+
+    for (size_t i = 0; i < count; i++)
+    {
+        decodedNormals[i] = polarNormals[i].ToVector3();
+    }
+
+    double decodeSeconds = GetElapsedSeconds(start);
+    double maxError, meanError;
+    getErrors(maxError, meanError);
+
+    output << L"Polar\t" << encodeSeconds << L"\t" << decodeSeconds << L"\t" << (count / encodeSeconds / 1e6) << L"\t" << (count / decodeSeconds / 1e6) << L"\t" << maxError << L"\t" << meanError << L"\t-" << std::endl;
+
+    for (int instructionSet = 0; instructionSet <= supportedInstructionSet; instructionSet++)
+    {
+        std::vector<OctahedralNormal> &outNormals = (instructionSet == 0) ? scalarNormals : octahedralNormals;
+
+        start = std::chrono::high_resolution_clock::now();
+        NormalCodec::Encode(normals, count, outNormals.data(), instructionSet);
+        encodeSeconds = GetElapsedSeconds(start);
+
+        start = std::chrono::high_resolution_clock::now();
+        NormalCodec::Decode(outNormals.data(), count, decodedNormals.data());
+        decodeSeconds = GetElapsedSeconds(start);
+
+        getErrors(maxError, meanError);
+        bool matching = std::equal(scalarNormals.begin(), scalarNormals.end(), outNormals.begin(), [](const OctahedralNormal &a, const OctahedralNormal &b) { return (a.x == b.x) && (a.y == b.y); });
+
+        output << kernelNames[instructionSet] << L"\t" << encodeSeconds << L"\t" << decodeSeconds << L"\t" << (count / encodeSeconds / 1e6) << L"\t" << (count / decodeSeconds / 1e6) << L"\t" << maxError << L"\t" << meanError << L"\t" << (matching ? L"Yes" : L"No") << std::endl;
+    }
+
+    output << std::endl;
+}
+
+void PointCloudEngine::Benchmark::ColorEncoding(std::wofstream &output, const PointBuffer &points)
+{
+    // Encode and decode all the vertex colors in every format with every kernel the processor supports
+    // The errors are in 8 bit steps, the luma error shows how well the brightness is kept which matters most for the perceived quality
+    std::wstring formatNames[3] = { L"RGB664", L"RGB565", L"YCoCg655" };
+    std::wstring kernelNames[3] = { L"Scalar", L"SSE2", L"AVX2" };
+    int supportedInstructionSet = KMeans::GetInstructionSet();
+    size_t count = points.GetCount();
+    const byte *rgb = points.GetColors();
+
+    std::vector<Color16> scalarColors(count);
+    std::vector<Color16> colors(count);
+    std::vector<Vector3> decodedColors(count);
+
+    output << L"# Color Encoding (" << count << L" colors)" << std::endl;
+    output << L"Format\tKernel\tEncode Seconds\tDecode Seconds\tMillion Colors/s Encoded\tMaximum Error\tMean Error\tMean Luma Error\tMatching Scalar" << std::endl;
+
+    for (int format = 0; format < 3; format++)
+    {
+        for (int instructionSet = 0; instructionSet <= supportedInstructionSet; instructionSet++)
+        {
+            std::vector<Color16> &outColors = (instructionSet == 0) ? scalarColors : colors;
+
+            auto start = std::chrono::high_resolution_clock::now();
+            ColorCodec::Encode(rgb, count, outColors.data(), (ColorFormat)format, instructionSet);
+            double encodeSeconds = GetElapsedSeconds(start);
+
+            start = std::chrono::high_resolution_clock::now();
+            ColorCodec::Decode(outColors.data(), count, decodedColors.data(), (ColorFormat)format);
+            double decodeSeconds = GetElapsedSeconds(start);
+
+            double maxError = 0;
+            double errorSum = 0;
+            double lumaErrorSum = 0;
+
+            for (size_t i = 0; i < count; i++)
+            {
+                double error[3];
+
+                for (int j = 0; j < 3; j++)
+                {
+                    double decoded = 255.0 * ((j == 0) ? decodedColors[i].x : ((j == 1) ? decodedColors[i].y : decodedColors[i].z));
+                    error[j] = decoded - rgb[3 * i + j];
+
+                    maxError = max(maxError, std::abs(error[j]));
+                    errorSum += std::abs(error[j]);
+                }
+
+                lumaErrorSum += std::abs(0.299 * error[0] + 0.587 * error[1] + 0.114 * error[2]);
+            }
+
+            bool matching = std::equal(scalarColors.begin(), scalarColors.end(), outColors.begin(), [](const Color16 &a, const Color16 &b) { return a.data == b.data; });
+
+            output << formatNames[format] << L"\t" << kernelNames[instructionSet] << L"\t" << encodeSeconds << L"\t" << decodeSeconds << L"\t" << (count / encodeSeconds / 1e6) << L"\t" << maxError << L"\t" << (errorSum / max(3 * count, (size_t)1)) << L"\t" << (lumaErrorSum / max(count, (size_t)1)) << L"\t" << (matching ? L"Yes" : L"No") << std::endl;
+        }
+    }
+
+    output << std::endl;
+}
+
+void PointCloudEngine::Benchmark::NodeAllocation(std::wofstream &output, const PointBuffer &points)
+{
+    // Same root cube as the octree, the recursive builder sorts the points of the nodes in place and therefore gets a copy
+    Vector3 minPosition, maxPosition;
+    points.GetBounds(minPosition, maxPosition);
+
+    PointBuffer sortedPoints = points;
+
+    Vector3 diagonal = maxPosition - minPosition;
+    Vector3 center = minPosition + 0.5f * diagonal;
+    float size = max(max(diagonal.x, diagonal.y), diagonal.z);
+
+    TaskScheduler scheduler(settings->buildThreadCount);
+    MemoryArena arena(scheduler.GetThreadCount());
+    OctreeNode *root = arena.Create<OctreeNode>(0, &sortedPoints, 0, sortedPoints.GetCount(), center, size, min(settings->maxOctreeDepth, MortonCode::maxDepth), 1, &arena, &scheduler);
+    size_t nodeCount = arena.GetAllocationCount();
+
+    // Compare with one heap allocation per node that is deleted recursively
+    OctreeNode *heapRoot = CopyToHeap(root);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    arena.Release();
+    double arenaSeconds = GetElapsedSeconds(start);
+
+    start = std::chrono::high_resolution_clock::now();
+    DeleteFromHeap(heapRoot);
+    double heapSeconds = GetElapsedSeconds(start);
+
+    output << L"# Node Allocation (" << nodeCount << L" nodes)" << std::endl;
+    output << L"Allocator\tHeap Allocations\tDestroy Milliseconds" << std::endl;
+    output << L"Heap\t" << nodeCount << L"\t" << (1000.0 * heapSeconds) << std::endl;
+    output << L"Arena\t" << arena.GetBlockCount() << L"\t" << (1000.0 * arenaSeconds) << std::endl;
+    output << std::endl;
+}
+
+void PointCloudEngine::Benchmark::DynamicUpdates(std::wofstream &output, const PointBuffer &points)
+{
+    bool dynamicOctree = settings->dynamicOctree;
+    settings->dynamicOctree = true;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    Octree *octree = new Octree(points, settings->maxOctreeDepth);
+    double buildSeconds = GetElapsedSeconds(start);
+
+    output << L"# Dynamic Updates (full build " << buildSeconds << L" seconds)" << std::endl;
+    output << L"Batch Size\tRemove Milliseconds\tInsert Milliseconds\tNodes" << std::endl;
+
+    // Remove a batch of evenly spread vertices and insert them again, this leaves the octree with the same vertices
+    size_t batchSizes[3] = { 1000, 10000, 100000 };
+
+    for (int i = 0; i < 3; i++)
+    {
+        if (batchSizes[i] > points.GetCount())
+        {
+            break;
+        }
+
+        std::vector<Vertex> batch;
+        size_t step = points.GetCount() / batchSizes[i];
+
+        for (size_t j = 0; j < batchSizes[i]; j++)
+        {
+            batch.push_back(points.GetVertex(j * step));
+        }
+
+        start = std::chrono::high_resolution_clock::now();
+        octree->Remove(batch);
+        double removeSeconds = GetElapsedSeconds(start);
+
+        start = std::chrono::high_resolution_clock::now();
+        octree->Insert(batch);
+        double insertSeconds = GetElapsedSeconds(start);
+
+        output << batchSizes[i] << L"\t" << (1000.0 * removeSeconds) << L"\t" << (1000.0 * insertSeconds) << L"\t" << octree->GetNodeCount() << std::endl;
+    }
+
+    // A NaN position and an outlier far outside of the largest root that the morton codes support are skipped without growing the root
+    std::vector<Vertex> invalidVertices(2, points.GetVertex(0));
+    invalidVertices[0].position.x = std::numeric_limits<float>::quiet_NaN();
+    invalidVertices[1].position.x = FLT_MAX;
+
+    size_t nodeCount = octree->GetNodeCount();
+    size_t insertedCount = octree->Insert(invalidVertices);
+
+    output << L"Invalid Positions Skipped: " << (((insertedCount == 0) && (octree->GetNodeCount() == nodeCount)) ? L"Yes" : L"No") << std::endl;
+    output << std::endl;
+    SafeDelete(octree);
+
+    settings->dynamicOctree = dynamicOctree;
+}
+
+void PointCloudEngine::Benchmark::OctreeCacheLoad(std::wofstream &output, const PointBuffer &points, const std::wstring &plyfile)
+{
+    bool dynamicOctree = settings->dynamicOctree;
+    settings->dynamicOctree = false;
+
+    output << L"# Octree Cache (" << OctreeCache::GetCacheFilename(plyfile) << L")" << std::endl;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    Octree *octree = new Octree(points, settings->maxOctreeDepth);
+    double buildSeconds = GetElapsedSeconds(start);
+
+    start = std::chrono::high_resolution_clock::now();
+    bool written = octree->WriteCache(plyfile, settings->maxOctreeDepth, points.GetCount());
+    double writeSeconds = GetElapsedSeconds(start);
+
+    UINT64 hash = octree->GetHash();
+    SafeDelete(octree);
+
+    // Opening includes the key of the ply file and the header checks, the nodes are only paged in by the hash afterwards
+    start = std::chrono::high_resolution_clock::now();
+    OctreeCache *cache = new OctreeCache(plyfile, settings->maxOctreeDepth);
+    bool valid = written && cache->IsValid();
+    double openSeconds = GetElapsedSeconds(start);
+
+    if (!valid)
+    {
+        output << L"Could not write the cache file" << std::endl << std::endl;
+        SafeDelete(cache);
+        settings->dynamicOctree = dynamicOctree;
+        return;
+    }
+
+    octree = new Octree(cache);
+
+    start = std::chrono::high_resolution_clock::now();
+    bool matching = (octree->GetHash() == hash);
+    double readSeconds = GetElapsedSeconds(start);
+
+    output << L"Step\tSeconds" << std::endl;
+    output << L"Build\t" << buildSeconds << std::endl;
+    output << L"Write\t" << writeSeconds << std::endl;
+    output << L"Open\t" << openSeconds << std::endl;
+    output << L"Read All Nodes\t" << readSeconds << std::endl;
+    output << L"Matching Nodes: " << (matching ? L"Yes" : L"No") << std::endl;
+    output << std::endl;
+
+    SafeDelete(octree);
+
+    settings->dynamicOctree = dynamicOctree;
+}
+
+void PointCloudEngine::Benchmark::StreamedTraversal(std::wofstream &output, const std::wstring &plyfile)
+{
+    // Uses the cache that was written by the octree cache benchmark
+    int octreePageBudget = settings->octreePageBudget;
+    bool dynamicOctree = settings->dynamicOctree;
+    settings->dynamicOctree = false;
+
+    output << L"# Streamed Traversal" << std::endl;
+
+    OctreeCache *cache = new OctreeCache(plyfile, settings->maxOctreeDepth);
+
+    if (!cache->IsValid())
+    {
+        output << L"No valid cache file" << std::endl << std::endl;
+        SafeDelete(cache);
+        settings->dynamicOctree = dynamicOctree;
+        return;
+    }
+
+    size_t nodeMegabytes = max((size_t)1, (cache->GetNodeCount() * sizeof(FlatOctreeNode)) / (1024 * 1024));
+    SafeDelete(cache);
+
+    output << L"Budget (MB)\tPages\tTraversal Milliseconds\tPage Loads\tMax Resident MB\tVertices\tMatching Vertices" << std::endl;
+
+    // The largest budget maps the whole cache, the smaller ones stream the pages
+    size_t mappedVertexCount = 0;
+    int budgets[3] = { 1 << 20, (int)max((size_t)1, nodeMegabytes / 4), (int)max((size_t)1, nodeMegabytes / 16) };
+
+    for (int i = 0; i < 3; i++)
+    {
+        settings->octreePageBudget = budgets[i];
+        cache = new OctreeCache(plyfile, settings->maxOctreeDepth);
+        size_t pageCount = cache->GetPageCount();
+        Octree *octree = new Octree(cache);
+
+        Vector3 rootPosition;
+        float rootSize;
+        octree->GetRootPositionAndSize(rootPosition, rootSize);
+
+        // Fly from far away into the center of the root cube like a camera would over several frames
+        size_t vertexCount = 0;
+        size_t maxResidentBytes = 0;
+        double seconds = 0;
+        std::vector<OctreeNodeVertex> octreeVertices;
+
+        for (int frame = 0; frame < 64; frame++)
+        {
+            Vector3 cameraPosition = rootPosition - (2.0f * rootSize * (1.0f - frame / 64.0f)) * Vector3::UnitZ;
+
+            auto start = std::chrono::high_resolution_clock::now();
+            octree->GetVertices(cameraPosition, ViewFrustum(), 0.01f, octreeVertices);
+            seconds += GetElapsedSeconds(start);
+            vertexCount += octreeVertices.size();
+
+            maxResidentBytes = max(maxResidentBytes, cache->GetResidentBytes());
+        }
+
+        if (i == 0)
+        {
+            mappedVertexCount = vertexCount;
+        }
+
+        std::wstring budget = (i == 0) ? L"Mapped" : std::to_wstring(budgets[i]);
+        output << budget << L"\t" << pageCount << L"\t" << (1000.0 * seconds) << L"\t" << cache->GetPageLoadCount() << L"\t" << (maxResidentBytes / (1024.0 * 1024.0)) << L"\t" << vertexCount << L"\t" << ((vertexCount == mappedVertexCount) ? L"Yes" : L"No") << std::endl;
+
+        SafeDelete(octree);
+    }
+
+    output << std::endl;
+
+    settings->octreePageBudget = octreePageBudget;
+    settings->dynamicOctree = dynamicOctree;
+}
+
+void PointCloudEngine::Benchmark::OutOfCoreBuild(std::wofstream &output, const PointBuffer &points, const std::wstring &plyfile)
+{
+    int outOfCoreMemoryBudget = settings->outOfCoreMemoryBudget;
+
+    output << L"# Out-of-Core Build (maxOctreeDepth=" << settings->maxOctreeDepth << L")" << std::endl;
+
+    if (OutOfCoreBuilder::GetVertexCount(plyfile) == 0)
+    {
+        output << L"Only binary little endian ply files are supported" << std::endl << std::endl;
+        return;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    Octree *octree = new Octree(points, settings->maxOctreeDepth);
+    double inMemorySeconds = GetElapsedSeconds(start);
+    size_t inMemoryNodeCount = octree->GetNodeCount();
+    SafeDelete(octree);
+
+    output << L"Budget (MB)\tSeconds\tNodes" << std::endl;
+    output << L"In Memory\t" << inMemorySeconds << L"\t" << inMemoryNodeCount << std::endl;
+
+    // Budgets smaller than the cloud force the vertices to be split into temporary files one or more times
+    size_t vertexMegabytes = max((size_t)1, (points.GetCount() * sizeof(Vertex)) / (1024 * 1024));
+
+    for (size_t divisor = 1; divisor <= 64; divisor *= 8)
+    {
+        settings->outOfCoreMemoryBudget = max((size_t)1, vertexMegabytes / divisor);
+
+        start = std::chrono::high_resolution_clock::now();
+        octree = new Octree(plyfile, settings->maxOctreeDepth);
+        double seconds = GetElapsedSeconds(start);
+
+        output << settings->outOfCoreMemoryBudget << L"\t" << seconds << L"\t" << octree->GetNodeCount() << std::endl;
+        SafeDelete(octree);
+    }
+
+    output << std::endl;
+
+    settings->outOfCoreMemoryBudget = outOfCoreMemoryBudget;
+}
+
+bool PointCloudEngine::Benchmark::Determinism()
+{
+    std::wofstream output(executableDirectory + DETERMINISM_FILENAME);
+    std::map<std::wstring, std::wstring> goldenHashes = ReadGoldenHashes();
+
+    // Save all the settings that change the octree
+    OctreeBuilder octreeBuilder = settings->octreeBuilder;
+    int buildThreadCount = settings->buildThreadCount;
+    int parallelBuildCutoff = settings->parallelBuildCutoff;
+    SubdivisionMode subdivisionMode = settings->subdivisionMode;
+    int maxLeafVertexCount = settings->maxLeafVertexCount;
+    float minNodeSize = settings->minNodeSize;
+    ClusteringMode clusteringMode = settings->clusteringMode;
+    int kMeansMaxIterations = settings->kMeansMaxIterations;
+    float kMeansTolerance = settings->kMeansTolerance;
+    bool dynamicOctree = settings->dynamicOctree;
+    ColorFormat colorFormat = settings->colorFormat;
+
+    // The golden hashes are only valid for these values, the hash includes the encoded cluster colors
+    const int depth = 8;
+    settings->maxLeafVertexCount = 64;
+    settings->minNodeSize = 0.0f;
+    settings->kMeansMaxIterations = 30;
+    settings->kMeansTolerance = 0.001f;
+    settings->dynamicOctree = false;
+    settings->colorFormat = ColorFormat::RGB565;
+
+    std::wstring cloudNames[4] = { L"Cube", L"Sphere", L"Clusters", L"Duplicates" };
+    OctreeBuilder builders[2] = { OctreeBuilder::TopDown, OctreeBuilder::Morton };
+    std::wstring builderNames[2] = { L"TopDown", L"Morton" };
+    SubdivisionMode modes[2] = { SubdivisionMode::FixedDepth, SubdivisionMode::Adaptive };
+    ClusteringMode clusteringModes[2] = { ClusteringMode::PerNode, ClusteringMode::BottomUp };
+    std::wstring modeNames[2] = { L"FixedDepth+PerNode", L"Adaptive+BottomUp" };
+
+    // A single thread, a few threads and all hardware threads with small subtrees that are stolen in a different order every time
+    int hardwareThreads = max(1, (int)std::thread::hardware_concurrency());
+    int threadCounts[3] = { 1, min(2, hardwareThreads), hardwareThreads };
+    int parallelBuildCutoffs[3] = { parallelBuildCutoff, 1000, 100 };
+
+    bool passed = true;
+
+    output << L"# Determinism (maxOctreeDepth=" << depth << L", hardware threads=" << hardwareThreads << L")" << std::endl;
+    output << L"Cloud\tBuilder\tMode\tHash\tThreads Matching\tGolden Hash" << std::endl;
+
+    for (int cloud = 0; cloud < 4; cloud++)
+    {
+        PointBuffer points = CreateSyntheticCloud(cloud, 50000);
+
+        for (int builder = 0; builder < 2; builder++)
+        {
+            for (int mode = 0; mode < 2; mode++)
+            {
+                settings->octreeBuilder = builders[builder];
+                settings->subdivisionMode = modes[mode];
+                settings->clusteringMode = clusteringModes[mode];
+
+                UINT64 hashes[3];
+
+                for (int i = 0; i < 3; i++)
+                {
+                    settings->buildThreadCount = threadCounts[i];
+                    settings->parallelBuildCutoff = parallelBuildCutoffs[i];
+
+                    Octree *octree = new Octree(points, depth);
+                    hashes[i] = octree->GetHash();
+                    SafeDelete(octree);
+                }
+
+                bool threadsMatching = (hashes[0] == hashes[1]) && (hashes[0] == hashes[2]);
+
+                std::wstringstream hash;
+                hash << std::hex << std::setw(16) << std::setfill(L'0') << hashes[0];
+
+                std::wstring key = cloudNames[cloud] + L"\t" + builderNames[builder] + L"\t" + modeNames[mode];
+                auto golden = goldenHashes.find(key);
+                std::wstring goldenResult = L"Missing";
+
+                // Rows that were not recorded on the reference build yet are only reported as missing, a recorded hash has to match
+                if (golden != goldenHashes.end())
+                {
+                    goldenResult = (golden->second == hash.str()) ? L"Yes" : (L"No (" + golden->second + L")");
+                    passed &= (golden->second == hash.str());
+                }
+
+                passed &= threadsMatching;
+
+                output << key << L"\t" << hash.str() << L"\t" << (threadsMatching ? L"Yes" : L"No") << L"\t" << goldenResult << std::endl;
+            }
+        }
+    }
+
+    output << std::endl;
+    output << (passed ? L"Passed" : L"Failed") << std::endl;
+    output.flush();
+    output.close();
+
+    settings->octreeBuilder = octreeBuilder;
+    settings->buildThreadCount = buildThreadCount;
+    settings->parallelBuildCutoff = parallelBuildCutoff;
+    settings->subdivisionMode = subdivisionMode;
+    settings->maxLeafVertexCount = maxLeafVertexCount;
+    settings->minNodeSize = minNodeSize;
+    settings->clusteringMode = clusteringMode;
+    settings->kMeansMaxIterations = kMeansMaxIterations;
+    settings->kMeansTolerance = kMeansTolerance;
+    settings->dynamicOctree = dynamicOctree;
+    settings->colorFormat = colorFormat;
+
+    return passed;
+}
+
+PointCloudEngine::PointBuffer PointCloudEngine::Benchmark::CreateSyntheticCloud(const int &shape, const size_t &vertexCount)
+{
+    // Use the raw generator output since the standard distributions are implementation defined
+    std::mt19937 generator(5489u + shape);
+    auto random = [&]() { return (generator() >> 8) / 16777216.0f; };
+    auto signedRandom = [&]() { return 2.0f * random() - 1.0f; };
+
+    PointBuffer points;
+    points.Resize(vertexCount);
+
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        Vertex vertex;
+        Vector3 direction(signedRandom(), signedRandom(), signedRandom());
+
+        if (direction.LengthSquared() < 1e-6f)
+        {
+            direction = Vector3::UnitZ;
+        }
+
+        direction.Normalize();
+
+        if (shape == 0)
+        {
+            // Uniform in a cube with random normals
+            vertex.position = Vector3(signedRandom(), signedRandom(), signedRandom());
+            vertex.normal = direction;
+        }
+        else if (shape == 1)
+        {
+            // Surface of a sphere with the normals pointing outwards
+            vertex.position = direction;
+            vertex.normal = direction;
+        }
+        else if (shape == 2)
+        {
+            // Dense clusters around 8 centers and a few sparse outliers
+            int center = generator() % 9;
+
+            if (center == 8)
+            {
+                vertex.position = 10.0f * Vector3(signedRandom(), signedRandom(), signedRandom());
+            }
+            else
+            {
+                vertex.position = 0.05f * direction + Vector3((float)(center & 1), (float)((center >> 1) & 1), (float)(center >> 2));
+            }
+
+            vertex.normal = Vector3(direction.x, direction.y, std::abs(direction.z));
+        }
+        else
+        {
+            // Only 64 distinct positions with many vertices each, these leaves can never be split
+            int position = generator() % 64;
+            vertex.position = Vector3((float)(position & 3), (float)((position >> 2) & 3), (float)(position >> 4));
+            vertex.normal = direction;
+        }
+
+        vertex.color[0] = generator() % 256;
+        vertex.color[1] = generator() % 256;
+        vertex.color[2] = generator() % 256;
+
+        points.SetVertex(i, vertex);
+    }
+
+    return points;
+}
+
+std::map<std::wstring, std::wstring> PointCloudEngine::Benchmark::ReadGoldenHashes()
+{
+    // Each line is the cloud, builder and mode followed by the hash, all separated by tabs
+    std::map<std::wstring, std::wstring> goldenHashes;
+    std::wifstream goldenFile(executableDirectory + GOLDEN_HASHES_FILENAME);
+    std::wstring line;
+
+    while (std::getline(goldenFile, line))
+    {
+        size_t separator = line.find_last_of(L'\t');
+
+        if (line.empty() || (line[0] == L'#') || (separator == std::wstring::npos))
+        {
+            continue;
+        }
+
+        goldenHashes[line.substr(0, separator)] = line.substr(separator + 1);
+    }
+
+    return goldenHashes;
+}
+
+PointCloudEngine::OctreeNode* PointCloudEngine::Benchmark::CopyToHeap(const OctreeNode *node)
+{
+    OctreeNode *copy = new OctreeNode(*node);
+
+    for (int i = 0; i < 8; i++)
+    {
+        if (node->children[i] != NULL)
+        {
+            copy->children[i] = CopyToHeap(node->children[i]);
+        }
+    }
+
+    return copy;
+}
+
+void PointCloudEngine::Benchmark::DeleteFromHeap(OctreeNode *node)
+{
+    for (int i = 0; i < 8; i++)
+    {
+        if (node->children[i] != NULL)
+        {
+            DeleteFromHeap(node->children[i]);
+        }
+    }
+
+    delete node;
+}
+
+double PointCloudEngine::Benchmark::GetElapsedSeconds(const std::chrono::high_resolution_clock::time_point &start)
+{
+    return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
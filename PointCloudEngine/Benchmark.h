@@ -0,0 +1,44 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#pragma once
+#include "PointCloudEngine.h"
+
+namespace PointCloudEngine
+{
+    class Benchmark
+    {
+    public:
+        // Runs all the benchmarks on the ply file without creating a window
+        // The results are written into benchmark.txt next to the executable
+        static void Run(std::wstring plyfile);
+
+        // Builds synthetic clouds with different thread counts and compares the octree hashes to each other and to the golden hashes
+        // The golden hashes are read from Assets/DeterminismHashes.txt, the results are written into determinism.txt next to the executable
+        // Returns false if any hash differs, missing golden hashes are only reported
+        static bool Determinism();
+
+    private:
+        static void PlyLoading(std::wofstream &output, const std::wstring &plyfile);
+        static void OctreeBuildScaling(std::wofstream &output, const PointBuffer &points);
+        static void OctreeBuilderComparison(std::wofstream &output, const PointBuffer &points);
+        static void SubdivisionModeComparison(std::wofstream &output, const PointBuffer &points);
+        static void OctreeTraversal(std::wofstream &output, const PointBuffer &points);
+        static void ClusteringModeComparison(std::wofstream &output, const PointBuffer &points);
+        static void ClusteringIterations(std::wofstream &output, const PointBuffer &points);
+        static void NodeAllocation(std::wofstream &output, const PointBuffer &points);
+        static void DynamicUpdates(std::wofstream &output, const PointBuffer &points);
+        static void OctreeCacheLoad(std::wofstream &output, const PointBuffer &points, const std::wstring &plyfile);
+        static void StreamedTraversal(std::wofstream &output, const std::wstring &plyfile);
+        static void OutOfCoreBuild(std::wofstream &output, const PointBuffer &points, const std::wstring &plyfile);
+        static void KMeansKernels(std::wofstream &output, const PointBuffer &points);
+        static void NormalEncoding(std::wofstream &output, const PointBuffer &points);
+        static void ColorEncoding(std::wofstream &output, const PointBuffer &points);
+        static PointBuffer CreateSyntheticCloud(const int &shape, const size_t &vertexCount);
+        static std::map<std::wstring, std::wstring> ReadGoldenHashes();
+        static OctreeNode* CopyToHeap(const OctreeNode *node);
+        static void DeleteFromHeap(OctreeNode *node);
+        static double GetElapsedSeconds(const std::chrono::high_resolution_clock::time_point &start);
+    };
+}
+#endif
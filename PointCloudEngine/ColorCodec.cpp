@@ -0,0 +1,196 @@
+#include "ColorCodec.h"
+
+void PointCloudEngine::ColorCodec::Encode(const byte *rgb, const size_t &count, Color16 *outColors, const ColorFormat &format, int instructionSet)
+{
+    static const int supportedInstructionSet = KMeans::GetInstructionSet();
+
+    if ((instructionSet < 0) || (instructionSet > supportedInstructionSet))
+    {
+        instructionSet = supportedInstructionSet;
+    }
+
+    const Channel *channels = GetChannels(format);
+
+    if (instructionSet == 2)
+    {
+        EncodeAVX2(rgb, count, outColors, channels);
+    }
+    else if (instructionSet == 1)
+    {
+        EncodeSSE(rgb, count, outColors, channels);
+    }
+    else
+    {
+        EncodeScalar(rgb, count, outColors, channels);
+    }
+}
+
+void PointCloudEngine::ColorCodec::Decode(const Color16 *colors, const size_t &count, Vector3 *outColors, const ColorFormat &format)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        UINT32 data = colors[i].data;
+
+        if (format == ColorFormat::RGB565)
+        {
+            outColors[i] = Vector3(((data >> 11) & 31) / 31.0f, ((data >> 5) & 63) / 63.0f, (data & 31) / 31.0f);
+        }
+        else if (format == ColorFormat::YCoCg655)
+        {
+            // Co is red minus blue and Cg is green minus the average of red and blue, both in the range [-1, 1]
+            float y = ((data >> 10) & 63) / 63.0f;
+            float co = 2.0f * (((data >> 5) & 31) / 31.0f) - 1.0f;
+            float cg = 2.0f * ((data & 31) / 31.0f) - 1.0f;
+
+            Vector3 color(y + 0.5f * co - 0.5f * cg, y + 0.5f * cg, y - 0.5f * co - 0.5f * cg);
+            outColors[i] = Vector3::Clamp(color, Vector3::Zero, Vector3::One);
+        }
+        else
+        {
+            outColors[i] = Vector3(((data >> 10) & 63) / 63.0f, ((data >> 4) & 63) / 63.0f, (data & 15) / 15.0f);
+        }
+    }
+}
+
+const PointCloudEngine::ColorCodec::Channel* PointCloudEngine::ColorCodec::GetChannels(const ColorFormat &format)
+{
+    static const Channel rgb664[3] =
+    {
+        { 1, 0, 0, 0, 63.0f / 255.0f, 10 },
+        { 0, 1, 0, 0, 63.0f / 255.0f, 4 },
+        { 0, 0, 1, 0, 15.0f / 255.0f, 0 }
+    };
+
+    static const Channel rgb565[3] =
+    {
+        { 1, 0, 0, 0, 31.0f / 255.0f, 11 },
+        { 0, 1, 0, 0, 63.0f / 255.0f, 5 },
+        { 0, 0, 1, 0, 31.0f / 255.0f, 0 }
+    };
+
+    // Y = (R + 2G + B) / 4, Co = R - B and Cg = (2G - R - B) / 2, the sums below are these values without the divisions
+    static const Channel yCoCg655[3] =
+    {
+        { 1, 2, 1, 0, 63.0f / 1020.0f, 10 },
+        { 1, 0, -1, 255, 31.0f / 510.0f, 5 },
+        { -1, 2, -1, 510, 31.0f / 1020.0f, 0 }
+    };
+
+    if (format == ColorFormat::RGB565)
+    {
+        return rgb565;
+    }
+    else if (format == ColorFormat::YCoCg655)
+    {
+        return yCoCg655;
+    }
+
+    return rgb664;
+}
+
+void PointCloudEngine::ColorCodec::EncodeScalar(const byte *rgb, const size_t &count, Color16 *outColors, const Channel channels[3])
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        const byte *color = rgb + 3 * i;
+        UINT32 data = 0;
+
+        for (int j = 0; j < 3; j++)
+        {
+            const Channel &channel = channels[j];
+            int sum = channel.red * color[0] + channel.green * color[1] + channel.blue * color[2] + channel.offset;
+
+            // The sum is never negative, truncating after adding 0.5 rounds to the nearest value
+            data |= (UINT32)((float)sum * channel.scale + 0.5f) << channel.shift;
+        }
+
+        outColors[i].data = data;
+    }
+}
+
+void PointCloudEngine::ColorCodec::EncodeSSE(const byte *rgb, const size_t &count, Color16 *outColors, const Channel channels[3])
+{
+    // The weighted sums are small integers and exact in floating point, this gives the same results as the integer sums of the scalar version
+    __m128 red[3], green[3], blue[3], offset[3], scale[3];
+
+    for (int j = 0; j < 3; j++)
+    {
+        red[j] = _mm_set1_ps((float)channels[j].red);
+        green[j] = _mm_set1_ps((float)channels[j].green);
+        blue[j] = _mm_set1_ps((float)channels[j].blue);
+        offset[j] = _mm_set1_ps((float)channels[j].offset);
+        scale[j] = _mm_set1_ps(channels[j].scale);
+    }
+
+    const __m128 half = _mm_set1_ps(0.5f);
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4)
+    {
+        const byte *color = rgb + 3 * i;
+        __m128 r = _mm_cvtepi32_ps(_mm_setr_epi32(color[0], color[3], color[6], color[9]));
+        __m128 g = _mm_cvtepi32_ps(_mm_setr_epi32(color[1], color[4], color[7], color[10]));
+        __m128 b = _mm_cvtepi32_ps(_mm_setr_epi32(color[2], color[5], color[8], color[11]));
+        __m128i data = _mm_setzero_si128();
+
+        for (int j = 0; j < 3; j++)
+        {
+            __m128 sum = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(r, red[j]), _mm_mul_ps(g, green[j])), _mm_mul_ps(b, blue[j])), offset[j]);
+            __m128i value = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(sum, scale[j]), half));
+            data = _mm_or_si128(data, _mm_sll_epi32(value, _mm_cvtsi32_si128(channels[j].shift)));
+        }
+
+        int result[4];
+        _mm_storeu_si128((__m128i*)result, data);
+
+        for (int j = 0; j < 4; j++)
+        {
+            outColors[i + j].data = result[j];
+        }
+    }
+
+    EncodeScalar(rgb + 3 * i, count - i, outColors + i, channels);
+}
+
+void PointCloudEngine::ColorCodec::EncodeAVX2(const byte *rgb, const size_t &count, Color16 *outColors, const Channel channels[3])
+{
+    __m256 red[3], green[3], blue[3], offset[3], scale[3];
+
+    for (int j = 0; j < 3; j++)
+    {
+        red[j] = _mm256_set1_ps((float)channels[j].red);
+        green[j] = _mm256_set1_ps((float)channels[j].green);
+        blue[j] = _mm256_set1_ps((float)channels[j].blue);
+        offset[j] = _mm256_set1_ps((float)channels[j].offset);
+        scale[j] = _mm256_set1_ps(channels[j].scale);
+    }
+
+    const __m256 half = _mm256_set1_ps(0.5f);
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8)
+    {
+        const byte *color = rgb + 3 * i;
+        __m256 r = _mm256_cvtepi32_ps(_mm256_setr_epi32(color[0], color[3], color[6], color[9], color[12], color[15], color[18], color[21]));
+        __m256 g = _mm256_cvtepi32_ps(_mm256_setr_epi32(color[1], color[4], color[7], color[10], color[13], color[16], color[19], color[22]));
+        __m256 b = _mm256_cvtepi32_ps(_mm256_setr_epi32(color[2], color[5], color[8], color[11], color[14], color[17], color[20], color[23]));
+        __m256i data = _mm256_setzero_si256();
+
+        for (int j = 0; j < 3; j++)
+        {
+            __m256 sum = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(r, red[j]), _mm256_mul_ps(g, green[j])), _mm256_mul_ps(b, blue[j])), offset[j]);
+            __m256i value = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(sum, scale[j]), half));
+            data = _mm256_or_si256(data, _mm256_sll_epi32(value, _mm_cvtsi32_si128(channels[j].shift)));
+        }
+
+        int result[8];
+        _mm256_storeu_si256((__m256i*)result, data);
+
+        for (int j = 0; j < 8; j++)
+        {
+            outColors[i + j].data = result[j];
+        }
+    }
+
+    EncodeScalar(rgb + 3 * i, count - i, outColors + i, channels);
+}
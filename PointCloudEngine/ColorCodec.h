@@ -0,0 +1,39 @@
+#ifndef COLORCODEC_H
+#define COLORCODEC_H
+
+#pragma once
+#include "PointCloudEngine.h"
+
+namespace PointCloudEngine
+{
+    class ColorCodec
+    {
+    public:
+        // Encodes the 8 bit RGB colors (3 bytes per color) into 16 bit colors, every kernel creates exactly the same bits
+        // The instruction set is detected at runtime and the benchmark can force a lower one (0=Scalar, 1=SSE2, 2=AVX2)
+        static void Encode(const byte *rgb, const size_t &count, Color16 *outColors, const ColorFormat &format, int instructionSet = -1);
+
+        // Decodes into RGB in the range [0, 1], the same as Color16ToFloat3 in Octree.hlsl
+        static void Decode(const Color16 *colors, const size_t &count, Vector3 *outColors, const ColorFormat &format);
+
+    private:
+        // Each of the 3 encoded values is a weighted sum of the 8 bit channels plus an offset to make it positive
+        // The sum is scaled to the amount of bits, rounded and shifted to its position in the 16 bits
+        struct Channel
+        {
+            int red;
+            int green;
+            int blue;
+            int offset;
+            float scale;
+            int shift;
+        };
+
+        static const Channel* GetChannels(const ColorFormat &format);
+
+        static void EncodeScalar(const byte *rgb, const size_t &count, Color16 *outColors, const Channel channels[3]);
+        static void EncodeSSE(const byte *rgb, const size_t &count, Color16 *outColors, const Channel channels[3]);
+        static void EncodeAVX2(const byte *rgb, const size_t &count, Color16 *outColors, const Channel channels[3]);
+    };
+}
+#endif
@@ -6,30 +6,49 @@
 
 namespace PointCloudEngine
 {
+    // Algorithms that can build the octree from the vertices
+    enum class OctreeBuilder
+    {
+        TopDown,    // Partitions the vertex range of each node into 8 consecutive child ranges in place without copying
+        Morton      // Sorts the vertices by their morton codes once and creates each node from a range of them
+    };
+
+    // When an octree node is split into its child cubes
+    enum class SubdivisionMode
+    {
+        FixedDepth, // All the nodes are subdivided until the maximum octree depth
+        Adaptive    // Only nodes with more than the maximum leaf vertex count that are larger than the minimum node size are subdivided
+    };
+
+    // How the normal clusters of the inner octree nodes are calculated
+    enum class ClusteringMode
+    {
+        PerNode,    // Every node clusters all the vertices inside of it with k-means
+        BottomUp    // Only the leaves cluster their vertices, inner nodes merge the clusters of their children
+    };
+
+    // Bits of the 16 bit cluster colors, decoded by Color16ToFloat3 in Octree.hlsl
+    enum class ColorFormat
+    {
+        RGB664,     // 6 bits red, 6 bits green, 4 bits blue
+        RGB565,     // 5 bits red, 6 bits green, 5 bits blue
+        YCoCg655    // 6 bits luma Y, 5 bits orange chroma Co, 5 bits green chroma Cg
+    };
+
     struct Color16
     {
-        // 6 bits: red, 6 bits green, 4 bits blue
+        // The bits depend on the color format of the octree, the colors are encoded with the ColorCodec
         unsigned short data;
 
         Color16()
         {
             data = 0;
         }
-
-        Color16(byte red, byte green, byte blue)
-        {
-            byte r = round(63 * (red / 255.0f));
-            byte g = round(63 * (green / 255.0f));
-            byte b = round(15 * (blue / 255.0f));
-
-            data = r << 10;
-            data = data | g << 4;
-            data = data | b;
-        }
     };
 
     struct PolarNormal
     {
+        // Previous normal encoding, only used to compare it to the octahedral normals in the benchmark
         // Compact representation of a normal with polar coordinates using inclination theta and azimuth phi
         // When theta=0 and phi=0 this represents an empty normal (0, 0, 0)
         // [0, pi] therefore 0=0, 255=pi
@@ -72,6 +91,78 @@ namespace PointCloudEngine
         }
     };
 
+    struct OctahedralNormal
+    {
+        // Compact representation of a normal projected onto the octahedron |x| + |y| + |z| = 1
+        // The lower half is folded over the diagonals into the corners, the unit square [-1, 1] is stored with 8 bits per axis
+        // When x=0 and y=0 this represents an empty normal (0, 0, 0), the corner (0, 0, -1) is stored as x=255 and y=255 instead
+        // The same bits are stored as the NormalCodec batch encoder creates, keep both and Octree.hlsl in sync
+        byte x;
+        byte y;
+
+        OctahedralNormal()
+        {
+            x = 0;
+            y = 0;
+        }
+
+        OctahedralNormal(const Vector3 &normal)
+        {
+            // No need to normalize, the projection divides by the sum of the absolute values anyways
+            float sum = (std::abs(normal.x) + std::abs(normal.y)) + std::abs(normal.z);
+
+            if (!(sum > 0))
+            {
+                x = 0;
+                y = 0;
+                return;
+            }
+
+            float u = normal.x / sum;
+            float v = normal.y / sum;
+
+            if (normal.z < 0)
+            {
+                float foldedU = (1.0f - std::abs(v)) * ((u >= 0) ? 1.0f : -1.0f);
+                float foldedV = (1.0f - std::abs(u)) * ((v >= 0) ? 1.0f : -1.0f);
+                u = foldedU;
+                v = foldedV;
+            }
+
+            // Round to the nearest of the 256 values, [-1, 1] therefore 0=-1, 255=1
+            x = (int)(u * 127.5f + 128.0f);
+            y = (int)(v * 127.5f + 128.0f);
+
+            if (x == 0 && y == 0)
+            {
+                x = 255;
+                y = 255;
+            }
+        }
+
+        Vector3 ToVector3() const
+        {
+            if (x == 0 && y == 0)
+            {
+                return Vector3(0, 0, 0);
+            }
+
+            float u = (x / 127.5f) - 1.0f;
+            float v = (y / 127.5f) - 1.0f;
+            Vector3 normal(u, v, 1.0f - std::abs(u) - std::abs(v));
+
+            if (normal.z < 0)
+            {
+                normal.x = (1.0f - std::abs(v)) * ((u >= 0) ? 1.0f : -1.0f);
+                normal.y = (1.0f - std::abs(u)) * ((v >= 0) ? 1.0f : -1.0f);
+            }
+
+            normal.Normalize();
+
+            return normal;
+        }
+    };
+
     struct Vertex
     {
         // Stores the .ply file vertices
@@ -80,21 +171,92 @@ namespace PointCloudEngine
         byte color[3];
     };
 
+    // Mean normal, vertex count and color sum of a cluster in full precision, used while building and by dynamic octrees
+    struct ClusterSummary
+    {
+        Vector3 mean;
+        UINT64 count = 0;
+        double colorSums[3] = { 0, 0, 0 };
+    };
+
+    // Vertex of a node that is uploaded to the GPU, the octree only stores the clusters and creates it during the traversal
     struct OctreeNodeVertex
     {
         // Bounding volume cube position
         Vector3 position;
 
         // The different cluster mean normals and colors in object space calculated by k-means algorithm with k=6
-        // Each weights is the percentage of points assigned to this cluster (0=0%, 255=100%)
-        // TODO: One weight can be omitted because the sum of all weights is always 1
-        PolarNormal normals[6];
+        // Each weights is the percentage of points assigned to this cluster (0=0%, 255=100%), the weights always sum up to 255
+        OctahedralNormal normals[6];
         Color16 colors[6];
         byte weights[6];
 
         // Width of the whole cube
         float size;
     };
+
+    struct FlatOctreeNode
+    {
+        // The position and size are not stored, they follow from the root cube and the child indices on the path to the node
+        // The sixth weight is not stored either since all the weights sum up to 255
+        OctahedralNormal normals[6];
+        Color16 colors[6];
+        byte weights[5];
+
+        // Bit i is set if the child with the child index i exists, leaf nodes have no bits set
+        byte childrenMask;
+
+        // Index of the first child in the node array, all the children are stored consecutively ordered by their child index
+        UINT32 childrenStart;
+
+        // Copies the clusters of the node vertex, the children are not changed
+        void SetClusters(const OctreeNodeVertex &nodeVertex)
+        {
+            std::copy(nodeVertex.normals, nodeVertex.normals + 6, normals);
+            std::copy(nodeVertex.colors, nodeVertex.colors + 6, colors);
+            std::copy(nodeVertex.weights, nodeVertex.weights + 5, weights);
+        }
+
+        OctreeNodeVertex GetNodeVertex(const Vector3 &position, const float &size) const
+        {
+            OctreeNodeVertex nodeVertex;
+            nodeVertex.position = position;
+            nodeVertex.size = size;
+
+            std::copy(normals, normals + 6, nodeVertex.normals);
+            std::copy(colors, colors + 6, nodeVertex.colors);
+            std::copy(weights, weights + 5, nodeVertex.weights);
+            nodeVertex.weights[5] = 255 - weights[0] - weights[1] - weights[2] - weights[3] - weights[4];
+
+            return nodeVertex;
+        }
+    };
+
+    // Normal clustering iterations of all the nodes at one octree level
+    struct ClusteringStatistics
+    {
+        size_t nodeCount = 0;
+        UINT64 iterations = 0;
+        int maxIterations = 0;
+
+        // Nodes that stopped at settings->kMeansMaxIterations before the means converged
+        size_t cappedNodeCount = 0;
+    };
+
+    // Shared between a build on a background thread and the thread that shows its progress
+    struct BuildProgress
+    {
+        // Stops the build as soon as possible, the result of a cancelled build is incomplete and has to be discarded
+        std::atomic<bool> cancelled{ false };
+
+        // The build is finished when all the vertices are processed, 0 vertices means that the vertex count is not known yet
+        std::atomic<UINT64> processedVertexCount{ 0 };
+        std::atomic<UINT64> vertexCount{ 0 };
+
+        // Reading the file before the build, 0 file bytes means that the file is not read or its size is not known yet
+        std::atomic<UINT64> readByteCount{ 0 };
+        std::atomic<UINT64> fileByteCount{ 0 };
+    };
 }
 
 #endif
\ No newline at end of file
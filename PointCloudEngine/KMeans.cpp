@@ -0,0 +1,589 @@
+#include "KMeans.h"
+
+// Two squared distances with the same square root differ at most by a factor of (1 + 2^-23)^2
+const float PointCloudEngine::KMeans::nearTieFactor = 1.0f - 1.0f / (1 << 20);
+
+// The bounds accumulate rounding errors over the iterations, normals that are this close to the bound test are assigned again
+const float PointCloudEngine::KMeans::boundTolerance = 1e-6f;
+
+int PointCloudEngine::KMeans::ClusterNormals(const Vector3 *normals, const size_t &count, Vector3 outMeans[6], int outCounts[6], byte *outClusters, int instructionSet)
+{
+    static const int supportedInstructionSet = GetInstructionSet();
+
+    if ((instructionSet < 0) || (instructionSet > supportedInstructionSet))
+    {
+        instructionSet = supportedInstructionSet;
+    }
+
+    const int k = SeedMeans(normals, count, min(count, 6), outMeans);
+
+    for (int i = 0; i < 6; i++)
+    {
+        outCounts[i] = 0;
+    }
+
+    // Hamerly's algorithm stores an upper bound of the distance to the assigned mean and a lower bound of the distance to all other means
+    // A normal can only change its cluster when the upper bound is larger than the lower bound
+    // Start with bounds that fail this test to assign all the normals in the first iteration
+    MemoryArena &scratchArena = MemoryArena::GetScratchArena();
+    MemoryArena::Marker marker = scratchArena.GetMarker();
+    float *upperBounds = scratchArena.AllocateArray<float>(count);
+    float *lowerBounds = scratchArena.AllocateArray<float>(count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        outClusters[i] = 0;
+        upperBounds[i] = FLT_MAX;
+        lowerBounds[i] = 0;
+    }
+
+    // Normals that fail the bound test are gathered into a batch as structure of arrays and assigned with the vectorized kernel
+    float x[batchSize], y[batchSize], z[batchSize], batchUpperBounds[batchSize], batchLowerBounds[batchSize];
+    byte batchClusters[batchSize];
+    size_t batchIndices[batchSize];
+    int batchCount = 0;
+
+    // How far each mean moved in the last iteration, the bounds are updated lazily in the next iteration
+    float meanMovements[6] = { 0, 0, 0, 0, 0, 0 };
+    float maxOtherMovements[6] = { 0, 0, 0, 0, 0, 0 };
+
+    bool meanChanged = true;
+    int iterations = 0;
+
+    const int maxIterations = max(1, settings->kMeansMaxIterations);
+
+    while (meanChanged && (iterations < maxIterations))
+    {
+        // A normal that is closer to its mean than half the distance from that mean to any other mean cannot be closer to another mean
+        float halfMeanDistances[6];
+
+        for (int i = 0; i < k; i++)
+        {
+            halfMeanDistances[i] = FLT_MAX;
+
+            for (int j = 0; j < k; j++)
+            {
+                if (i != j)
+                {
+                    halfMeanDistances[i] = min(halfMeanDistances[i], 0.5f * Vector3::Distance(outMeans[i], outMeans[j]));
+                }
+            }
+        }
+
+        // Assign the vertices to the closest mean
+        auto assignBatch = [&]()
+        {
+            if (instructionSet == 2)
+            {
+                AssignBatchAVX2(x, y, z, batchCount, outMeans, k, batchClusters, batchUpperBounds, batchLowerBounds);
+            }
+            else if (instructionSet == 1)
+            {
+                AssignBatchSSE(x, y, z, batchCount, outMeans, k, batchClusters, batchUpperBounds, batchLowerBounds);
+            }
+            else
+            {
+                AssignBatchScalar(x, y, z, batchCount, outMeans, k, batchClusters, batchUpperBounds, batchLowerBounds);
+            }
+
+            for (int i = 0; i < batchCount; i++)
+            {
+                outClusters[batchIndices[i]] = batchClusters[i];
+                upperBounds[batchIndices[i]] = batchUpperBounds[i];
+                lowerBounds[batchIndices[i]] = batchLowerBounds[i];
+            }
+
+            batchCount = 0;
+        };
+
+        for (size_t i = 0; i < count; i++)
+        {
+            const Vector3 &normal = normals[i];
+            byte cluster = outClusters[i];
+
+            upperBounds[i] += meanMovements[cluster];
+            lowerBounds[i] -= maxOtherMovements[cluster];
+
+            // Only the normals that fail the bound test are assigned again, the others keep their cluster without computing any distances
+            if (upperBounds[i] + boundTolerance >= max(halfMeanDistances[cluster], lowerBounds[i]))
+            {
+                x[batchCount] = normal.x;
+                y[batchCount] = normal.y;
+                z[batchCount] = normal.z;
+                batchClusters[batchCount] = cluster;
+                batchIndices[batchCount] = i;
+
+                if (++batchCount == batchSize)
+                {
+                    assignBatch();
+                }
+            }
+        }
+
+        if (batchCount > 0)
+        {
+            assignBatch();
+        }
+
+        // Sum up the new means in the order of the normals and not in the order of the batches
+        // This keeps the means bit identical no matter which normals were pruned or which kernel assigned them
+        Vector3 sums[6];
+        int counts[6] = { 0, 0, 0, 0, 0, 0 };
+
+        for (size_t i = 0; i < count; i++)
+        {
+            sums[outClusters[i]] += normals[i];
+            counts[outClusters[i]]++;
+        }
+
+        meanChanged = false;
+        iterations++;
+
+        // Update the means, empty clusters keep their old mean
+        for (int i = 0; i < k; i++)
+        {
+            outCounts[i] = counts[i];
+            meanMovements[i] = 0;
+
+            if (counts[i] > 0)
+            {
+                sums[i] /= counts[i];
+                meanMovements[i] = Vector3::Distance(outMeans[i], sums[i]);
+
+                if (meanMovements[i] > settings->kMeansTolerance)
+                {
+                    meanChanged = true;
+                }
+
+                outMeans[i] = sums[i];
+            }
+        }
+
+        // The lower bound of a normal decreases by the largest movement of all the other means
+        for (int i = 0; i < k; i++)
+        {
+            maxOtherMovements[i] = 0;
+
+            for (int j = 0; j < k; j++)
+            {
+                if (i != j)
+                {
+                    maxOtherMovements[i] = max(maxOtherMovements[i], meanMovements[j]);
+                }
+            }
+        }
+    }
+
+    scratchArena.Rewind(marker);
+
+    return iterations;
+}
+
+int PointCloudEngine::KMeans::ClusterWeightedNormals(const Vector3 *normals, const UINT64 *weights, const int &count, Vector3 outMeans[6], byte *outClusters)
+{
+    std::mt19937 generator(5489u);
+    int k = 0;
+
+    for (int i = 0; i < 6; i++)
+    {
+        outMeans[i] = Vector3();
+    }
+
+    // Weighted k-means++ seeding, the probability is proportional to the weight times the squared distance to the closest mean
+    // The first mean is the normal with the largest weight
+    double minDistances[48];
+    int first = std::max_element(weights, weights + count) - weights;
+
+    for (int i = 0; i < count; i++)
+    {
+        minDistances[i] = DBL_MAX;
+    }
+
+    if (count > 0)
+    {
+        outMeans[k++] = normals[first];
+    }
+
+    while (k < min(count, 6))
+    {
+        double sum = 0;
+
+        for (int i = 0; i < count; i++)
+        {
+            minDistances[i] = min(minDistances[i], (double)weights[i] * Vector3::DistanceSquared(normals[i], outMeans[k - 1]));
+            sum += minDistances[i];
+        }
+
+        if (sum <= 0)
+        {
+            break;
+        }
+
+        double target = (generator() / 4294967296.0) * sum;
+        int picked = count - 1;
+
+        for (int i = 0; i < count; i++)
+        {
+            target -= minDistances[i];
+
+            if ((target < 0) && (minDistances[i] > 0))
+            {
+                picked = i;
+                break;
+            }
+        }
+
+        while (minDistances[picked] <= 0)
+        {
+            picked--;
+        }
+
+        outMeans[k++] = normals[picked];
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        outClusters[i] = 0;
+    }
+
+    bool meanChanged = true;
+    int iterations = 0;
+    const int maxIterations = max(1, settings->kMeansMaxIterations);
+
+    while (meanChanged && (iterations < maxIterations))
+    {
+        Vector3 sums[6];
+        double weightSums[6] = { 0, 0, 0, 0, 0, 0 };
+
+        for (int i = 0; i < count; i++)
+        {
+            int cluster = outClusters[i];
+            float minDistance = Vector3::DistanceSquared(normals[i], outMeans[cluster]);
+
+            for (int j = 0; j < k; j++)
+            {
+                float distance = Vector3::DistanceSquared(normals[i], outMeans[j]);
+
+                if (distance < minDistance)
+                {
+                    cluster = j;
+                    minDistance = distance;
+                }
+            }
+
+            outClusters[i] = cluster;
+            sums[cluster] += (float)weights[i] * normals[i];
+            weightSums[cluster] += weights[i];
+        }
+
+        meanChanged = false;
+        iterations++;
+
+        for (int i = 0; i < k; i++)
+        {
+            if (weightSums[i] > 0)
+            {
+                sums[i] /= weightSums[i];
+
+                if (Vector3::Distance(outMeans[i], sums[i]) > settings->kMeansTolerance)
+                {
+                    meanChanged = true;
+                }
+
+                outMeans[i] = sums[i];
+            }
+        }
+    }
+
+    return iterations;
+}
+
+int PointCloudEngine::KMeans::GetInstructionSet()
+{
+    int cpuInfo[4];
+    __cpuid(cpuInfo, 0);
+    int maxFunction = cpuInfo[0];
+
+    __cpuid(cpuInfo, 1);
+    bool sse2 = (cpuInfo[3] & (1 << 26)) != 0;
+
+    // The operating system also has to save the AVX registers (OSXSAVE and AVX bits)
+    if (((cpuInfo[2] & (1 << 27)) == 0) || ((cpuInfo[2] & (1 << 28)) == 0) || ((_xgetbv(0) & 6) != 6) || (maxFunction < 7))
+    {
+        return sse2 ? 1 : 0;
+    }
+
+    __cpuidex(cpuInfo, 7, 0);
+
+    if ((cpuInfo[1] & (1 << 5)) != 0)
+    {
+        return 2;
+    }
+
+    return sse2 ? 1 : 0;
+}
+
+int PointCloudEngine::KMeans::SeedMeans(const Vector3 *normals, const size_t &count, const int &k, Vector3 outMeans[6])
+{
+    // Use the raw generator output since the standard distributions are implementation defined
+    std::mt19937 generator(5489u);
+
+    for (int i = 0; i < 6; i++)
+    {
+        outMeans[i] = Vector3();
+    }
+
+    if (k == 0)
+    {
+        return 0;
+    }
+
+    // The first mean is picked uniformly
+    outMeans[0] = normals[generator() % count];
+
+    MemoryArena &scratchArena = MemoryArena::GetScratchArena();
+    MemoryArena::Marker marker = scratchArena.GetMarker();
+    float *minDistances = scratchArena.AllocateArray<float>(count);
+    int seeds = 1;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        minDistances[i] = FLT_MAX;
+    }
+
+    while (seeds < k)
+    {
+        // Update the squared distance of each normal to the closest mean with the last mean
+        double sum = 0;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            minDistances[i] = min(minDistances[i], Vector3::DistanceSquared(normals[i], outMeans[seeds - 1]));
+            sum += minDistances[i];
+        }
+
+        // All the normals are equal to one of the means, there are no more distinct means
+        if (sum <= 0)
+        {
+            break;
+        }
+
+        // Pick the normal where the cumulative squared distance exceeds a random fraction of the sum
+        double target = (generator() / 4294967296.0) * sum;
+        double cumulative = 0;
+        size_t picked = count - 1;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            cumulative += minDistances[i];
+
+            if ((cumulative > target) && (minDistances[i] > 0))
+            {
+                picked = i;
+                break;
+            }
+        }
+
+        // Rounding of the cumulative sum might reach the end, make sure that the picked normal is not a mean already
+        while (minDistances[picked] <= 0)
+        {
+            picked--;
+        }
+
+        outMeans[seeds++] = normals[picked];
+    }
+
+    scratchArena.Rewind(marker);
+
+    return seeds;
+}
+
+void PointCloudEngine::KMeans::AssignBatchScalar(const float *x, const float *y, const float *z, const int &count, const Vector3 means[6], const int &k, byte *clusters, float *upperBounds, float *lowerBounds)
+{
+    for (int i = 0; i < count; i++)
+    {
+        int assignedCluster = clusters[i];
+        int cluster = assignedCluster;
+        float minDistance = (x[i] - means[cluster].x) * (x[i] - means[cluster].x) + (y[i] - means[cluster].y) * (y[i] - means[cluster].y) + (z[i] - means[cluster].z) * (z[i] - means[cluster].z);
+        float secondDistance = FLT_MAX;
+
+        for (int j = 0; j < k; j++)
+        {
+            if (j == assignedCluster)
+            {
+                continue;
+            }
+
+            float distance = (x[i] - means[j].x) * (x[i] - means[j].x) + (y[i] - means[j].y) * (y[i] - means[j].y) + (z[i] - means[j].z) * (z[i] - means[j].z);
+
+            if ((distance < minDistance) && ((distance < minDistance * nearTieFactor) || (sqrtf(distance) < sqrtf(minDistance))))
+            {
+                cluster = j;
+                secondDistance = min(secondDistance, minDistance);
+                minDistance = distance;
+            }
+            else
+            {
+                secondDistance = min(secondDistance, distance);
+            }
+        }
+
+        clusters[i] = cluster;
+        upperBounds[i] = sqrtf(minDistance);
+        lowerBounds[i] = sqrtf(secondDistance);
+    }
+}
+
+void PointCloudEngine::KMeans::AssignBatchSSE(const float *x, const float *y, const float *z, const int &count, const Vector3 means[6], const int &k, byte *clusters, float *upperBounds, float *lowerBounds)
+{
+    // Broadcast each mean component into its own register
+    __m128 meanX[6], meanY[6], meanZ[6];
+
+    for (int j = 0; j < k; j++)
+    {
+        meanX[j] = _mm_set1_ps(means[j].x);
+        meanY[j] = _mm_set1_ps(means[j].y);
+        meanZ[j] = _mm_set1_ps(means[j].z);
+    }
+
+    int i = 0;
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 normalX = _mm_loadu_ps(x + i);
+        __m128 normalY = _mm_loadu_ps(y + i);
+        __m128 normalZ = _mm_loadu_ps(z + i);
+
+        // Squared distance to every mean, summed up in the same order as the scalar version
+        __m128 distances[6];
+
+        for (int j = 0; j < k; j++)
+        {
+            __m128 dx = _mm_sub_ps(normalX, meanX[j]);
+            __m128 dy = _mm_sub_ps(normalY, meanY[j]);
+            __m128 dz = _mm_sub_ps(normalZ, meanZ[j]);
+
+            distances[j] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        }
+
+        // Start with the distance to the currently assigned mean
+        __m128i assignedCluster = _mm_setr_epi32(clusters[i], clusters[i + 1], clusters[i + 2], clusters[i + 3]);
+        __m128i cluster = assignedCluster;
+        __m128 minDistance = _mm_setzero_ps();
+        __m128 secondDistance = _mm_set1_ps(FLT_MAX);
+
+        for (int j = 0; j < k; j++)
+        {
+            __m128 mask = _mm_castsi128_ps(_mm_cmpeq_epi32(cluster, _mm_set1_epi32(j)));
+            minDistance = _mm_or_ps(_mm_and_ps(mask, distances[j]), _mm_andnot_ps(mask, minDistance));
+        }
+
+        // Only switch to a mean that is strictly closer
+        for (int j = 0; j < k; j++)
+        {
+            __m128 assigned = _mm_castsi128_ps(_mm_cmpeq_epi32(assignedCluster, _mm_set1_epi32(j)));
+            __m128 closer = _mm_cmplt_ps(distances[j], minDistance);
+            __m128 nearTie = _mm_and_ps(closer, _mm_cmpge_ps(distances[j], _mm_mul_ps(minDistance, _mm_set1_ps(nearTieFactor))));
+
+            if (_mm_movemask_ps(nearTie) != 0)
+            {
+                closer = _mm_andnot_ps(_mm_and_ps(nearTie, _mm_cmpeq_ps(_mm_sqrt_ps(distances[j]), _mm_sqrt_ps(minDistance))), closer);
+            }
+
+            // The previous closest mean becomes the second closest, the assigned mean itself is not a candidate for the second closest
+            __m128 candidate = _mm_or_ps(_mm_and_ps(assigned, secondDistance), _mm_andnot_ps(assigned, _mm_min_ps(secondDistance, distances[j])));
+            secondDistance = _mm_or_ps(_mm_and_ps(closer, _mm_min_ps(secondDistance, minDistance)), _mm_andnot_ps(closer, candidate));
+            minDistance = _mm_or_ps(_mm_and_ps(closer, distances[j]), _mm_andnot_ps(closer, minDistance));
+            cluster = _mm_or_si128(_mm_and_si128(_mm_castps_si128(closer), _mm_set1_epi32(j)), _mm_andnot_si128(_mm_castps_si128(closer), cluster));
+        }
+
+        _mm_storeu_ps(upperBounds + i, _mm_sqrt_ps(minDistance));
+        _mm_storeu_ps(lowerBounds + i, _mm_sqrt_ps(secondDistance));
+
+        int assigned[4];
+        _mm_storeu_si128((__m128i*)assigned, cluster);
+
+        for (int lane = 0; lane < 4; lane++)
+        {
+            clusters[i + lane] = assigned[lane];
+        }
+    }
+
+    // Remaining normals that don't fill a whole register
+    AssignBatchScalar(x + i, y + i, z + i, count - i, means, k, clusters + i, upperBounds + i, lowerBounds + i);
+}
+
+void PointCloudEngine::KMeans::AssignBatchAVX2(const float *x, const float *y, const float *z, const int &count, const Vector3 means[6], const int &k, byte *clusters, float *upperBounds, float *lowerBounds)
+{
+    // Same as the SSE version with 8 normals at once
+    __m256 meanX[6], meanY[6], meanZ[6];
+
+    for (int j = 0; j < k; j++)
+    {
+        meanX[j] = _mm256_set1_ps(means[j].x);
+        meanY[j] = _mm256_set1_ps(means[j].y);
+        meanZ[j] = _mm256_set1_ps(means[j].z);
+    }
+
+    int i = 0;
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 normalX = _mm256_loadu_ps(x + i);
+        __m256 normalY = _mm256_loadu_ps(y + i);
+        __m256 normalZ = _mm256_loadu_ps(z + i);
+
+        // No fused multiply add to get exactly the same distances as the other versions
+        __m256 distances[6];
+
+        for (int j = 0; j < k; j++)
+        {
+            __m256 dx = _mm256_sub_ps(normalX, meanX[j]);
+            __m256 dy = _mm256_sub_ps(normalY, meanY[j]);
+            __m256 dz = _mm256_sub_ps(normalZ, meanZ[j]);
+
+            distances[j] = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+        }
+
+        __m256i assignedCluster = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(clusters + i)));
+        __m256i cluster = assignedCluster;
+        __m256 minDistance = _mm256_setzero_ps();
+        __m256 secondDistance = _mm256_set1_ps(FLT_MAX);
+
+        for (int j = 0; j < k; j++)
+        {
+            __m256 mask = _mm256_castsi256_ps(_mm256_cmpeq_epi32(cluster, _mm256_set1_epi32(j)));
+            minDistance = _mm256_blendv_ps(minDistance, distances[j], mask);
+        }
+
+        for (int j = 0; j < k; j++)
+        {
+            __m256 assigned = _mm256_castsi256_ps(_mm256_cmpeq_epi32(assignedCluster, _mm256_set1_epi32(j)));
+            __m256 closer = _mm256_cmp_ps(distances[j], minDistance, _CMP_LT_OQ);
+            __m256 nearTie = _mm256_and_ps(closer, _mm256_cmp_ps(distances[j], _mm256_mul_ps(minDistance, _mm256_set1_ps(nearTieFactor)), _CMP_GE_OQ));
+
+            if (_mm256_movemask_ps(nearTie) != 0)
+            {
+                closer = _mm256_andnot_ps(_mm256_and_ps(nearTie, _mm256_cmp_ps(_mm256_sqrt_ps(distances[j]), _mm256_sqrt_ps(minDistance), _CMP_EQ_OQ)), closer);
+            }
+
+            __m256 candidate = _mm256_blendv_ps(_mm256_min_ps(secondDistance, distances[j]), secondDistance, assigned);
+            secondDistance = _mm256_blendv_ps(candidate, _mm256_min_ps(secondDistance, minDistance), closer);
+            minDistance = _mm256_blendv_ps(minDistance, distances[j], closer);
+            cluster = _mm256_blendv_epi8(cluster, _mm256_set1_epi32(j), _mm256_castps_si256(closer));
+        }
+
+        _mm256_storeu_ps(upperBounds + i, _mm256_sqrt_ps(minDistance));
+        _mm256_storeu_ps(lowerBounds + i, _mm256_sqrt_ps(secondDistance));
+
+        int assigned[8];
+        _mm256_storeu_si256((__m256i*)assigned, cluster);
+
+        for (int lane = 0; lane < 8; lane++)
+        {
+            clusters[i + lane] = assigned[lane];
+        }
+    }
+
+    AssignBatchScalar(x + i, y + i, z + i, count - i, means, k, clusters + i, upperBounds + i, lowerBounds + i);
+}
@@ -0,0 +1,48 @@
+#ifndef KMEANS_H
+#define KMEANS_H
+
+#pragma once
+#include "PointCloudEngine.h"
+
+namespace PointCloudEngine
+{
+    class KMeans
+    {
+    public:
+        // Clusters the normals into k = min(count, 6) clusters with the k-means algorithm, only reads the normal array of the points
+        // Outputs the mean normal and normal count of each cluster and the cluster index of each normal
+        // Stops when no mean moves more than settings->kMeansTolerance or after settings->kMeansMaxIterations
+        // Returns the amount of iterations, the instruction set is detected at runtime and the benchmark can force a lower one
+        static int ClusterNormals(const Vector3 *normals, const size_t &count, Vector3 outMeans[6], int outCounts[6], byte *outClusters, int instructionSet = -1);
+
+        // Clusters the weighted normals into k = min(count, 6) clusters, used to merge the clusters of the child nodes
+        // The normals are few (at most 48) and therefore always clustered with the scalar algorithm
+        static int ClusterWeightedNormals(const Vector3 *normals, const UINT64 *weights, const int &count, Vector3 outMeans[6], byte *outClusters);
+
+        // Returns 2 if AVX2 is supported, 1 for SSE2 and 0 otherwise
+        static int GetInstructionSet();
+
+    private:
+        // Amount of normals that are converted to structure of arrays at once
+        static const int batchSize = 256;
+
+        // Squared distances that are closer than this factor can never round to the same distance after a square root
+        static const float nearTieFactor;
+
+        // Margin for the bound test that makes the pruned assignments equal to assigning every normal
+        static const float boundTolerance;
+
+        // k-means++ seeding, each mean is picked randomly with a probability proportional to the squared distance to the closest mean so far
+        // Uses a fixed seed to create the same octree every time, returns the amount of distinct means that were found
+        static int SeedMeans(const Vector3 *normals, const size_t &count, const int &k, Vector3 outMeans[6]);
+
+        // Assign each normal of the batch to the closest mean
+        // A normal only changes its cluster if another mean is strictly closer, the squared distances are compared
+        // Near ties are resolved with the square root to get exactly the same assignments as comparing distances
+        // Outputs the distance to the assigned mean and to the second closest mean as bounds for the next iteration
+        static void AssignBatchScalar(const float *x, const float *y, const float *z, const int &count, const Vector3 means[6], const int &k, byte *clusters, float *upperBounds, float *lowerBounds);
+        static void AssignBatchSSE(const float *x, const float *y, const float *z, const int &count, const Vector3 means[6], const int &k, byte *clusters, float *upperBounds, float *lowerBounds);
+        static void AssignBatchAVX2(const float *x, const float *y, const float *z, const int &count, const Vector3 means[6], const int &k, byte *clusters, float *upperBounds, float *lowerBounds);
+    };
+}
+#endif
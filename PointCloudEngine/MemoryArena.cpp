@@ -0,0 +1,139 @@
+// OutOfCoreBuilder.h stores a MemoryArena by value, the engine header includes it after this class
+#include "PointCloudEngine.h"
+
+PointCloudEngine::MemoryArena::MemoryArena(const int &threadCount, const size_t &blockSize)
+{
+    this->blockSize = blockSize;
+
+    // Separate allocations to keep the bump pointers of the threads in different cache lines
+    for (int i = 0; i < max(1, threadCount); i++)
+    {
+        threads.push_back(new ThreadBlocks());
+    }
+}
+
+PointCloudEngine::MemoryArena::~MemoryArena()
+{
+    Release();
+
+    for (auto it = threads.begin(); it != threads.end(); it++)
+    {
+        SafeDelete(*it);
+    }
+}
+
+void* PointCloudEngine::MemoryArena::Allocate(const size_t &size, const int &threadIndex)
+{
+    ThreadBlocks *thread = threads[threadIndex];
+    size_t alignedSize = (size + alignment - 1) & ~(alignment - 1);
+    thread->allocationCount++;
+
+    // Continue with the next block that has enough space, after rewinding the blocks are reused
+    while (thread->blockIndex < thread->blocks.size())
+    {
+        if (thread->offset + alignedSize <= thread->blockSizes[thread->blockIndex])
+        {
+            void *memory = thread->blocks[thread->blockIndex] + thread->offset;
+            thread->offset += alignedSize;
+
+            return memory;
+        }
+
+        thread->blockIndex++;
+        thread->offset = 0;
+    }
+
+    // Allocations that are larger than the block size get their own block
+    size_t newBlockSize = max(blockSize, alignedSize);
+    byte *block = (byte*)_aligned_malloc(newBlockSize, alignment);
+
+    if (block == NULL)
+    {
+        throw std::bad_alloc();
+    }
+
+    thread->blocks.push_back(block);
+    thread->blockSizes.push_back(newBlockSize);
+    thread->blockIndex = thread->blocks.size() - 1;
+    thread->offset = alignedSize;
+    thread->blockCount++;
+
+    return block;
+}
+
+PointCloudEngine::MemoryArena::Marker PointCloudEngine::MemoryArena::GetMarker(const int &threadIndex)
+{
+    ThreadBlocks *thread = threads[threadIndex];
+    Marker marker = { thread->blockIndex, thread->offset };
+
+    return marker;
+}
+
+void PointCloudEngine::MemoryArena::Rewind(const Marker &marker, const int &threadIndex)
+{
+    ThreadBlocks *thread = threads[threadIndex];
+
+    // Free the large blocks that were allocated after the marker, otherwise e.g. the arrays of the root node would stay allocated
+    for (size_t i = thread->blocks.size(); i-- > marker.blockIndex;)
+    {
+        if ((thread->blockSizes[i] > blockSize) && ((i > marker.blockIndex) || (marker.offset == 0)))
+        {
+            _aligned_free(thread->blocks[i]);
+            thread->blocks.erase(thread->blocks.begin() + i);
+            thread->blockSizes.erase(thread->blockSizes.begin() + i);
+        }
+    }
+
+    thread->blockIndex = marker.blockIndex;
+    thread->offset = marker.offset;
+}
+
+void PointCloudEngine::MemoryArena::Release()
+{
+    for (auto it = threads.begin(); it != threads.end(); it++)
+    {
+        ThreadBlocks *thread = *it;
+
+        for (auto block = thread->blocks.begin(); block != thread->blocks.end(); block++)
+        {
+            _aligned_free(*block);
+        }
+
+        thread->blocks.clear();
+        thread->blockSizes.clear();
+        thread->blockIndex = 0;
+        thread->offset = 0;
+    }
+}
+
+size_t PointCloudEngine::MemoryArena::GetBlockCount()
+{
+    size_t blockCount = 0;
+
+    for (auto it = threads.begin(); it != threads.end(); it++)
+    {
+        blockCount += (*it)->blockCount;
+    }
+
+    return blockCount;
+}
+
+size_t PointCloudEngine::MemoryArena::GetAllocationCount()
+{
+    size_t allocationCount = 0;
+
+    for (auto it = threads.begin(); it != threads.end(); it++)
+    {
+        allocationCount += (*it)->allocationCount;
+    }
+
+    return allocationCount;
+}
+
+PointCloudEngine::MemoryArena& PointCloudEngine::MemoryArena::GetScratchArena()
+{
+    // Smaller blocks than the node arenas since most nodes only have a few vertices
+    static thread_local MemoryArena scratchArena(1, 1024 * 1024);
+
+    return scratchArena;
+}
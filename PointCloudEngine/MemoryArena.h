@@ -0,0 +1,70 @@
+#ifndef MEMORYARENA_H
+#define MEMORYARENA_H
+
+#pragma once
+#include "PointCloudEngine.h"
+
+namespace PointCloudEngine
+{
+    // Bump allocator that hands out memory from large blocks and frees all of it at once
+    // Each thread index has its own blocks, the workers of a task scheduler allocate with their worker index without any locking
+    class MemoryArena
+    {
+    public:
+        // Position in the blocks of one thread index, rewinding to it frees everything that was allocated afterwards
+        struct Marker
+        {
+            size_t blockIndex;
+            size_t offset;
+        };
+
+        MemoryArena(const int &threadCount = 1, const size_t &blockSize = 4 * 1024 * 1024);
+        ~MemoryArena();
+
+        void* Allocate(const size_t &size, const int &threadIndex = 0);
+
+        // Objects that are created in the arena are never destructed, only use this for types without a destructor
+        template<typename T, typename... Arguments> T* Create(const int &threadIndex, Arguments&&... arguments)
+        {
+            return new (Allocate(sizeof(T), threadIndex)) T(std::forward<Arguments>(arguments)...);
+        }
+
+        template<typename T> T* AllocateArray(const size_t &count, const int &threadIndex = 0)
+        {
+            return (T*)Allocate(count * sizeof(T), threadIndex);
+        }
+
+        // The blocks are kept for the next allocations, only blocks that are larger than the block size are freed
+        Marker GetMarker(const int &threadIndex = 0);
+        void Rewind(const Marker &marker, const int &threadIndex = 0);
+
+        // Frees all the blocks of all thread indices
+        void Release();
+
+        // Amount of blocks that were allocated on the heap and amount of allocations that the arena served
+        size_t GetBlockCount();
+        size_t GetAllocationCount();
+
+        // Arena of the calling thread for temporary arrays, e.g. the clustering arrays of a node
+        // Reused by all the builds on this thread, allocations have to be rewound when they are not needed anymore
+        static MemoryArena& GetScratchArena();
+
+    private:
+        struct ThreadBlocks
+        {
+            std::vector<byte*> blocks;
+            std::vector<size_t> blockSizes;
+            size_t blockIndex = 0;
+            size_t offset = 0;
+            size_t blockCount = 0;
+            size_t allocationCount = 0;
+        };
+
+        // Enough for all the SIMD loads and the vertex types
+        static const size_t alignment = 16;
+
+        size_t blockSize;
+        std::vector<ThreadBlocks*> threads;
+    };
+}
+#endif
@@ -0,0 +1,111 @@
+#include "MortonCode.h"
+
+UINT64 PointCloudEngine::MortonCode::Encode(const UINT32 &x, const UINT32 &y, const UINT32 &z)
+{
+    // The x bit is the highest bit of each level, same as in the child index
+    return (SplitBy3(x) << 2) | (SplitBy3(y) << 1) | SplitBy3(z);
+}
+
+UINT64 PointCloudEngine::MortonCode::Calculate(const Vector3 &position, const Vector3 &cubeMin, const float &cubeSize, const int &depth)
+{
+    // Quantize the position to the cell coordinates
+    UINT32 cells = 1u << depth;
+    float scale = (cubeSize > 0) ? (cells / cubeSize) : 0;
+    Vector3 cell = scale * (position - cubeMin);
+
+    UINT32 x = min(cells - 1, (UINT32)max(0.0f, cell.x));
+    UINT32 y = min(cells - 1, (UINT32)max(0.0f, cell.y));
+    UINT32 z = min(cells - 1, (UINT32)max(0.0f, cell.z));
+
+    // Child index 0 is the positive octant, therefore flip the coordinates
+    return Encode(cells - 1 - x, cells - 1 - y, cells - 1 - z);
+}
+
+void PointCloudEngine::MortonCode::Sort(std::vector<UINT64> &codes, std::vector<UINT32> &indices, const int &bits, TaskScheduler *scheduler)
+{
+    size_t count = codes.size();
+    int chunkCount = scheduler->GetThreadCount();
+
+    // Double buffering, each pass scatters from one buffer into the other
+    std::vector<UINT64> tmpCodes(count);
+    std::vector<UINT32> tmpIndices(count);
+
+    // One histogram per chunk, the chunks are consecutive ranges which keeps the sort stable
+    std::vector<size_t> histograms(256 * chunkCount);
+
+    for (int shift = 0; shift < bits; shift += 8)
+    {
+        std::fill(histograms.begin(), histograms.end(), 0);
+
+        scheduler->ParallelFor(count, [&](const int &chunk, const size_t &begin, const size_t &end)
+        {
+            size_t *histogram = &histograms[256 * chunk];
+
+            for (size_t i = begin; i < end; i++)
+            {
+                histogram[(codes[i] >> shift) & 255]++;
+            }
+        });
+
+        // Skip the pass if all the codes have the same digit
+        bool sorted = false;
+
+        for (int digit = 0; digit < 256; digit++)
+        {
+            size_t digitCount = 0;
+
+            for (int chunk = 0; chunk < chunkCount; chunk++)
+            {
+                digitCount += histograms[256 * chunk + digit];
+            }
+
+            sorted |= (digitCount == count);
+        }
+
+        if (sorted)
+        {
+            continue;
+        }
+
+        // Turn the histograms into the output offsets, ordered by digit first and chunk second
+        size_t offset = 0;
+
+        for (int digit = 0; digit < 256; digit++)
+        {
+            for (int chunk = 0; chunk < chunkCount; chunk++)
+            {
+                size_t digitCount = histograms[256 * chunk + digit];
+                histograms[256 * chunk + digit] = offset;
+                offset += digitCount;
+            }
+        }
+
+        scheduler->ParallelFor(count, [&](const int &chunk, const size_t &begin, const size_t &end)
+        {
+            size_t *offsets = &histograms[256 * chunk];
+
+            for (size_t i = begin; i < end; i++)
+            {
+                size_t destination = offsets[(codes[i] >> shift) & 255]++;
+                tmpCodes[destination] = codes[i];
+                tmpIndices[destination] = indices[i];
+            }
+        });
+
+        codes.swap(tmpCodes);
+        indices.swap(tmpIndices);
+    }
+}
+
+UINT64 PointCloudEngine::MortonCode::SplitBy3(const UINT32 &value)
+{
+    // Insert two zero bits between each of the lowest 21 bits
+    UINT64 x = value & 0x1fffff;
+    x = (x | x << 32) & 0x1f00000000ffff;
+    x = (x | x << 16) & 0x1f0000ff0000ff;
+    x = (x | x << 8) & 0x100f00f00f00f00f;
+    x = (x | x << 4) & 0x10c30c30c30c30c3;
+    x = (x | x << 2) & 0x1249249249249249;
+
+    return x;
+}
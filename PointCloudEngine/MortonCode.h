@@ -0,0 +1,29 @@
+#ifndef MORTONCODE_H
+#define MORTONCODE_H
+
+#pragma once
+#include "PointCloudEngine.h"
+
+namespace PointCloudEngine
+{
+    class MortonCode
+    {
+    public:
+        // 3 * 21 bits fit into 64 bits, this also limits the node ids to this depth
+        static const int maxDepth = 21;
+
+        // Interleaves the lowest 21 bits of the cell coordinates to xyzxyz...xyz
+        static UINT64 Encode(const UINT32 &x, const UINT32 &y, const UINT32 &z);
+
+        // Morton code of the leaf cell at this position in the root cube with 2^depth cells along each axis
+        // The axes are flipped so that the 3 bits of each level are equal to the child index that OctreeNode uses
+        static UINT64 Calculate(const Vector3 &position, const Vector3 &cubeMin, const float &cubeSize, const int &depth);
+
+        // Stable parallel LSD radix sort with 8 bits per pass of the codes and their indices, only the lowest bits are sorted
+        static void Sort(std::vector<UINT64> &codes, std::vector<UINT32> &indices, const int &bits, TaskScheduler *scheduler);
+
+    private:
+        static UINT64 SplitBy3(const UINT32 &value);
+    };
+}
+#endif
@@ -0,0 +1,143 @@
+#include "NormalCodec.h"
+
+void PointCloudEngine::NormalCodec::Encode(const Vector3 *normals, const size_t &count, OctahedralNormal *outNormals, int instructionSet)
+{
+    static const int supportedInstructionSet = KMeans::GetInstructionSet();
+
+    if ((instructionSet < 0) || (instructionSet > supportedInstructionSet))
+    {
+        instructionSet = supportedInstructionSet;
+    }
+
+    if (instructionSet == 2)
+    {
+        EncodeAVX2(normals, count, outNormals);
+    }
+    else if (instructionSet == 1)
+    {
+        EncodeSSE(normals, count, outNormals);
+    }
+    else
+    {
+        EncodeScalar(normals, count, outNormals);
+    }
+}
+
+void PointCloudEngine::NormalCodec::Decode(const OctahedralNormal *normals, const size_t &count, Vector3 *outNormals)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        outNormals[i] = normals[i].ToVector3();
+    }
+}
+
+void PointCloudEngine::NormalCodec::EncodeScalar(const Vector3 *normals, const size_t &count, OctahedralNormal *outNormals)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        outNormals[i] = OctahedralNormal(normals[i]);
+    }
+}
+
+void PointCloudEngine::NormalCodec::EncodeSSE(const Vector3 *normals, const size_t &count, OctahedralNormal *outNormals)
+{
+    // Same operations in the same order as the scalar version, multiplying with the sign is the same as setting the sign bit of a positive value
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(127.5f);
+    const __m128 offset = _mm_set1_ps(128.0f);
+
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x = _mm_setr_ps(normals[i].x, normals[i + 1].x, normals[i + 2].x, normals[i + 3].x);
+        __m128 y = _mm_setr_ps(normals[i].y, normals[i + 1].y, normals[i + 2].y, normals[i + 3].y);
+        __m128 z = _mm_setr_ps(normals[i].z, normals[i + 1].z, normals[i + 2].z, normals[i + 3].z);
+
+        __m128 sum = _mm_add_ps(_mm_add_ps(_mm_andnot_ps(signMask, x), _mm_andnot_ps(signMask, y)), _mm_andnot_ps(signMask, z));
+        __m128 valid = _mm_cmpgt_ps(sum, zero);
+
+        __m128 u = _mm_div_ps(x, sum);
+        __m128 v = _mm_div_ps(y, sum);
+
+        // Fold the lower half into the corners
+        __m128 foldedU = _mm_or_ps(_mm_sub_ps(one, _mm_andnot_ps(signMask, v)), _mm_and_ps(_mm_cmplt_ps(u, zero), signMask));
+        __m128 foldedV = _mm_or_ps(_mm_sub_ps(one, _mm_andnot_ps(signMask, u)), _mm_and_ps(_mm_cmplt_ps(v, zero), signMask));
+        __m128 lower = _mm_cmplt_ps(z, zero);
+        u = _mm_or_ps(_mm_and_ps(lower, foldedU), _mm_andnot_ps(lower, u));
+        v = _mm_or_ps(_mm_and_ps(lower, foldedV), _mm_andnot_ps(lower, v));
+
+        // Empty normals are zero, the corner (0, 0, -1) is moved to the other corner
+        __m128i encodedX = _mm_and_si128(_mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(u, scale), offset)), _mm_castps_si128(valid));
+        __m128i encodedY = _mm_and_si128(_mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, scale), offset)), _mm_castps_si128(valid));
+        __m128i corner = _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi32(encodedX, _mm_setzero_si128()), _mm_cmpeq_epi32(encodedY, _mm_setzero_si128())), _mm_castps_si128(valid));
+        encodedX = _mm_or_si128(encodedX, _mm_and_si128(corner, _mm_set1_epi32(255)));
+        encodedY = _mm_or_si128(encodedY, _mm_and_si128(corner, _mm_set1_epi32(255)));
+
+        int resultX[4], resultY[4];
+        _mm_storeu_si128((__m128i*)resultX, encodedX);
+        _mm_storeu_si128((__m128i*)resultY, encodedY);
+
+        for (int j = 0; j < 4; j++)
+        {
+            outNormals[i + j].x = resultX[j];
+            outNormals[i + j].y = resultY[j];
+        }
+    }
+
+    EncodeScalar(normals + i, count - i, outNormals + i);
+}
+
+void PointCloudEngine::NormalCodec::EncodeAVX2(const Vector3 *normals, const size_t &count, OctahedralNormal *outNormals)
+{
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 scale = _mm256_set1_ps(127.5f);
+    const __m256 offset = _mm256_set1_ps(128.0f);
+
+    // Gather the components of 8 consecutive normals
+    const __m256i indices = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8)
+    {
+        const float *components = &normals[i].x;
+        __m256 x = _mm256_i32gather_ps(components, indices, 4);
+        __m256 y = _mm256_i32gather_ps(components + 1, indices, 4);
+        __m256 z = _mm256_i32gather_ps(components + 2, indices, 4);
+
+        __m256 sum = _mm256_add_ps(_mm256_add_ps(_mm256_andnot_ps(signMask, x), _mm256_andnot_ps(signMask, y)), _mm256_andnot_ps(signMask, z));
+        __m256 valid = _mm256_cmp_ps(sum, zero, _CMP_GT_OQ);
+
+        __m256 u = _mm256_div_ps(x, sum);
+        __m256 v = _mm256_div_ps(y, sum);
+
+        __m256 foldedU = _mm256_or_ps(_mm256_sub_ps(one, _mm256_andnot_ps(signMask, v)), _mm256_and_ps(_mm256_cmp_ps(u, zero, _CMP_LT_OQ), signMask));
+        __m256 foldedV = _mm256_or_ps(_mm256_sub_ps(one, _mm256_andnot_ps(signMask, u)), _mm256_and_ps(_mm256_cmp_ps(v, zero, _CMP_LT_OQ), signMask));
+        __m256 lower = _mm256_cmp_ps(z, zero, _CMP_LT_OQ);
+        u = _mm256_blendv_ps(u, foldedU, lower);
+        v = _mm256_blendv_ps(v, foldedV, lower);
+
+        __m256i encodedX = _mm256_and_si256(_mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(u, scale), offset)), _mm256_castps_si256(valid));
+        __m256i encodedY = _mm256_and_si256(_mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(v, scale), offset)), _mm256_castps_si256(valid));
+        __m256i corner = _mm256_and_si256(_mm256_and_si256(_mm256_cmpeq_epi32(encodedX, _mm256_setzero_si256()), _mm256_cmpeq_epi32(encodedY, _mm256_setzero_si256())), _mm256_castps_si256(valid));
+        encodedX = _mm256_or_si256(encodedX, _mm256_and_si256(corner, _mm256_set1_epi32(255)));
+        encodedY = _mm256_or_si256(encodedY, _mm256_and_si256(corner, _mm256_set1_epi32(255)));
+
+        int resultX[8], resultY[8];
+        _mm256_storeu_si256((__m256i*)resultX, encodedX);
+        _mm256_storeu_si256((__m256i*)resultY, encodedY);
+
+        for (int j = 0; j < 8; j++)
+        {
+            outNormals[i + j].x = resultX[j];
+            outNormals[i + j].y = resultY[j];
+        }
+    }
+
+    EncodeScalar(normals + i, count - i, outNormals + i);
+}
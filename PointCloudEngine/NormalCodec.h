@@ -0,0 +1,25 @@
+#ifndef NORMALCODEC_H
+#define NORMALCODEC_H
+
+#pragma once
+#include "PointCloudEngine.h"
+
+namespace PointCloudEngine
+{
+    class NormalCodec
+    {
+    public:
+        // Encodes the normals into octahedral normals, every kernel creates exactly the same bits as the OctahedralNormal constructor
+        // The instruction set is detected at runtime and the benchmark can force a lower one (0=Scalar, 1=SSE2, 2=AVX2)
+        static void Encode(const Vector3 *normals, const size_t &count, OctahedralNormal *outNormals, int instructionSet = -1);
+
+        // Decodes into unit length normals, empty normals are decoded to (0, 0, 0)
+        static void Decode(const OctahedralNormal *normals, const size_t &count, Vector3 *outNormals);
+
+    private:
+        static void EncodeScalar(const Vector3 *normals, const size_t &count, OctahedralNormal *outNormals);
+        static void EncodeSSE(const Vector3 *normals, const size_t &count, OctahedralNormal *outNormals);
+        static void EncodeAVX2(const Vector3 *normals, const size_t &count, OctahedralNormal *outNormals);
+    };
+}
+#endif
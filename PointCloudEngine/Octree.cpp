@@ -1,43 +1,1193 @@
 #include "Octree.h"
 
-PointCloudEngine::Octree::Octree(const std::vector<Vertex> &vertices, const int &depth)
+PointCloudEngine::Octree::Octree(PointBuffer points, const int &depth, BuildProgress *progress)
 {
-    // Calculate center and size of the root node
-    Vector3 minPosition = vertices.front().position;
-    Vector3 maxPosition = minPosition;
-
-    for (auto it = vertices.begin(); it != vertices.end(); it++)
+    if (progress != NULL)
     {
-        Vertex v = *it;
-
-        minPosition = Vector3::Min(minPosition, v.position);
-        maxPosition = Vector3::Max(maxPosition, v.position);
+        progress->vertexCount = points.GetCount();
     }
 
+    // Calculate center and size of the root node
+    Vector3 minPosition, maxPosition;
+    points.GetBounds(minPosition, maxPosition);
+
     Vector3 diagonal = maxPosition - minPosition;
     Vector3 center = minPosition + 0.5f * (diagonal);
     float size = max(max(diagonal.x, diagonal.y), diagonal.z);
 
-    root = new OctreeNode(vertices, center, size, depth);
+    rootPosition = center;
+    rootSize = size;
+    colorFormat = settings->colorFormat;
+
+    // The node ids and morton codes store 3 bits per level in 64 bits
+    int maxDepth = min(depth, MortonCode::maxDepth);
+
+    // Build the child subtrees in parallel with the configured amount of threads
+    TaskScheduler scheduler(settings->buildThreadCount);
+    OctreeNode *root = NULL;
+
+    // The linked nodes are only needed for building, they are all freed at once with the arena
+    MemoryArena arena(scheduler.GetThreadCount());
+
+    // Both builders reorder the points in place, afterwards the points are the same in another order
+    if (settings->octreeBuilder == OctreeBuilder::Morton)
+    {
+        root = BuildMorton(points, center, size, maxDepth, &arena, &scheduler, progress);
+    }
+    else
+    {
+        // The recursive builder partitions the point range of each node in place
+        root = arena.Create<OctreeNode>(0, &points, 0, points.GetCount(), center, size, maxDepth, 1, &arena, &scheduler, progress);
+    }
+
+    // Only keep the flat node array
+    Flatten(root, 0, nodes, clusteringStatistics);
+    arena.Release();
+
+    if (settings->dynamicOctree && !((progress != NULL) && progress->cancelled))
+    {
+        InitializeDynamicNodes(points, maxDepth, &scheduler);
+    }
+}
+
+UINT64 PointCloudEngine::Octree::GetBuildMemorySize(const UINT64 &vertexCount)
+{
+    // The point buffer has 2 vectors and 3 color bytes per point, the builders reorder it in place
+    // The morton builder also sorts 64 bit codes with 32 bit indices and reorders each array through a temporary copy of one vector array
+    UINT64 pointSize = 2 * sizeof(Vector3) + 3;
+
+    if (settings->octreeBuilder == OctreeBuilder::Morton)
+    {
+        pointSize += sizeof(UINT64) + sizeof(UINT32) + sizeof(Vector3);
+    }
+
+    return vertexCount * pointSize;
+}
+
+PointCloudEngine::Octree::Octree(const std::wstring &plyfile, const int &depth, BuildProgress *progress)
+{
+    OutOfCoreBuilder builder(plyfile, progress);
+    colorFormat = settings->colorFormat;
+
+    if (!builder.Build(min(depth, MortonCode::maxDepth), nodes, clusteringStatistics, rootPosition, rootSize))
+    {
+        if ((progress == NULL) || !progress->cancelled)
+        {
+            ErrorMessage(L"Could not build the octree out-of-core from " + plyfile, L"Octree", __FILEW__, __LINE__);
+        }
+
+        // Keep no nodes to render nothing
+        nodes.clear();
+        clusteringStatistics.clear();
+    }
+}
+
+PointCloudEngine::Octree::Octree(OctreeCache *cache)
+{
+    this->cache = cache;
+    clusteringStatistics = cache->GetClusteringStatistics();
+    cache->GetRootPositionAndSize(rootPosition, rootSize);
+
+    // The cache key contains the color format, a valid cache was built with the current one
+    colorFormat = settings->colorFormat;
 }
 
 PointCloudEngine::Octree::~Octree()
 {
-    SafeDelete(root);
+    SafeDelete(cache);
 }
 
-std::vector<OctreeNodeVertex> PointCloudEngine::Octree::GetVertices(const Vector3 &localCameraPosition, const float &splatSize)
+bool PointCloudEngine::Octree::WriteCache(const std::wstring &plyfile, const int &depth, const UINT64 &vertexCount)
 {
-    return root->GetVertices(localCameraPosition, splatSize);
+    // The unused nodes of dynamic octrees would be written as well and the leaf vertices would be missing
+    if (IsDynamic() || (cache != NULL))
+    {
+        return false;
+    }
+
+    // There are no nodes when the out-of-core build failed
+    if (nodes.empty())
+    {
+        return false;
+    }
+
+    return OctreeCache::Write(plyfile, depth, vertexCount, rootPosition, rootSize, nodes.data(), nodes.size(), clusteringStatistics);
 }
 
-std::vector<OctreeNodeVertex> PointCloudEngine::Octree::GetVerticesAtLevel(const int &level)
+void PointCloudEngine::Octree::GetVertices(const Vector3 &localCameraPosition, const ViewFrustum &frustum, const float &splatSize, std::vector<OctreeNodeVertex> &outVertices)
 {
-    return root->GetVerticesAtLevel(level);
+    // TODO: Visibility culling by comparing the maximum angle (normal cone) from the mean to all normals in the cluster against the view direction
+    outVertices.clear();
+    traversalStack.clear();
+
+    if (GetNodeCount() > 0)
+    {
+        int outsideMask, insideMask;
+        frustum.TestCubes(&rootPosition, 1, rootSize, outsideMask, insideMask);
+
+        if (outsideMask == 0)
+        {
+            traversalStack.push_back({ 0, rootPosition, rootSize, 0, insideMask != 0 });
+        }
+    }
+
+    // Scales the local space splat size by the fov, multiplied with the camera distance this is the splat size at that distance in local space
+    float splatSizeScale = splatSize * (2.0f * tan(settings->fovAngleY / 2.0f));
+
+    while (!traversalStack.empty())
+    {
+        TraversalEntry entry = traversalStack.back();
+        traversalStack.pop_back();
+
+        // Only return a vertex if its projected size is smaller than the passed size or it is a leaf node
+        const FlatOctreeNode &node = GetNode(entry.index);
+        float requiredSplatSize = splatSizeScale * Vector3::Distance(localCameraPosition, entry.position);
+
+        if ((entry.size < requiredSplatSize) || (node.childrenMask == 0))
+        {
+            // Make sure that e.g. single point nodes with size 0 are drawn as well
+            if (entry.size < FLT_EPSILON)
+            {
+                // Set the size temporarily to the splat size in local space to make sure that this node is visible
+                outVertices.push_back(node.GetNodeVertex(entry.position, requiredSplatSize));
+            }
+            else
+            {
+                outVertices.push_back(node.GetNodeVertex(entry.position, entry.size));
+            }
+        }
+        else
+        {
+            PushChildren(node, entry, frustum);
+        }
+    }
+
+    // Streamed pages that were not reached by this traversal can be evicted now
+    if (cache != NULL)
+    {
+        cache->EvictPages();
+    }
+}
+
+void PointCloudEngine::Octree::GetVerticesAtLevel(const int &level, std::vector<OctreeNodeVertex> &outVertices)
+{
+    outVertices.clear();
+    traversalStack.clear();
+
+    if ((GetNodeCount() > 0) && (level >= 0))
+    {
+        traversalStack.push_back({ 0, rootPosition, rootSize, level, true });
+    }
+
+    while (!traversalStack.empty())
+    {
+        TraversalEntry entry = traversalStack.back();
+        traversalStack.pop_back();
+
+        const FlatOctreeNode &node = GetNode(entry.index);
+
+        if (entry.level == 0)
+        {
+            outVertices.push_back(node.GetNodeVertex(entry.position, entry.size));
+        }
+        else
+        {
+            PushChildren(node, entry, ViewFrustum());
+        }
+    }
+
+    // Streamed pages that were not reached by this traversal can be evicted now
+    if (cache != NULL)
+    {
+        cache->EvictPages();
+    }
 }
 
 void PointCloudEngine::Octree::GetRootPositionAndSize(Vector3 &outRootPosition, float &outSize)
 {
-    outRootPosition = root->nodeVertex.position;
-    outSize = root->nodeVertex.size;
-}
\ No newline at end of file
+    outRootPosition = rootPosition;
+    outSize = rootSize;
+}
+
+ColorFormat PointCloudEngine::Octree::GetColorFormat()
+{
+    return colorFormat;
+}
+
+size_t PointCloudEngine::Octree::GetNodeCount()
+{
+    if (cache != NULL)
+    {
+        return cache->GetNodeCount();
+    }
+
+    return nodes.size() - unusedNodeCount;
+}
+
+std::vector<ClusteringStatistics> PointCloudEngine::Octree::GetClusteringStatistics()
+{
+    return clusteringStatistics;
+}
+
+UINT64 PointCloudEngine::Octree::GetHash()
+{
+    UINT64 hash = 14695981039346656037ull;
+
+    auto hashBytes = [&](const void *data, const size_t &size)
+    {
+        const byte *bytes = (const byte*)data;
+
+        for (size_t i = 0; i < size; i++)
+        {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+    };
+
+    if (GetNodeCount() == 0)
+    {
+        return hash;
+    }
+
+    // The cubes of the nodes follow from the root cube and the children masks
+    hashBytes(&rootPosition, sizeof(Vector3));
+    hashBytes(&rootSize, sizeof(float));
+
+    // Follow the children instead of iterating the array to skip the unused nodes of dynamic octrees
+    std::vector<UINT32> queue = { 0 };
+
+    for (size_t i = 0; i < queue.size(); i++)
+    {
+        const FlatOctreeNode &node = GetNode(queue[i]);
+
+        for (int j = 0; j < 6; j++)
+        {
+            hashBytes(&node.normals[j].x, 1);
+            hashBytes(&node.normals[j].y, 1);
+            hashBytes(&node.colors[j].data, sizeof(unsigned short));
+        }
+
+        hashBytes(node.weights, 5);
+        hashBytes(&node.childrenMask, 1);
+
+        UINT32 childIndex = node.childrenStart;
+
+        for (int j = 0; j < 8; j++)
+        {
+            if (node.childrenMask & (1 << j))
+            {
+                queue.push_back(childIndex++);
+            }
+        }
+
+        // Keep the streamed pages within the budget while all the nodes are read
+        if ((cache != NULL) && ((i + 1) % 65536 == 0))
+        {
+            cache->EvictPages();
+        }
+    }
+
+    if (cache != NULL)
+    {
+        cache->EvictPages();
+    }
+
+    return hash;
+}
+
+const PointCloudEngine::FlatOctreeNode& PointCloudEngine::Octree::GetNode(const UINT32 &index)
+{
+    return (cache != NULL) ? cache->GetNode(index) : nodes[index];
+}
+
+PointCloudEngine::OctreeNode* PointCloudEngine::Octree::BuildMorton(PointBuffer &points, const Vector3 &center, const float &size, const int &depth, MemoryArena *arena, TaskScheduler *scheduler, BuildProgress *progress)
+{
+    size_t vertexCount = points.GetCount();
+    const Vector3 *positions = points.GetPositions();
+    Vector3 cubeMin = center - Vector3(0.5f * size, 0.5f * size, 0.5f * size);
+
+    // Calculate the morton code of the leaf cell that each vertex is in, only reads the positions
+    std::vector<UINT64> mortonCodes(vertexCount);
+    std::vector<UINT32> indices(vertexCount);
+
+    scheduler->ParallelFor(vertexCount, [&](const int &chunk, const size_t &begin, const size_t &end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            mortonCodes[i] = MortonCode::Calculate(positions[i], cubeMin, size, depth);
+            indices[i] = i;
+        }
+    });
+
+    // Sort only once, afterwards each node is a consecutive range of the sorted vertices
+    MortonCode::Sort(mortonCodes, indices, 3 * depth, scheduler);
+
+    // Reorder the arrays of the points one after another, only one array at a time is gathered into a temporary copy
+    std::vector<Vector3> sortedVectors(vertexCount);
+
+    auto sortArray = [&](Vector3 *vectors)
+    {
+        scheduler->ParallelFor(vertexCount, [&](const int &chunk, const size_t &begin, const size_t &end)
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                sortedVectors[i] = vectors[indices[i]];
+            }
+        });
+
+        scheduler->ParallelFor(vertexCount, [&](const int &chunk, const size_t &begin, const size_t &end)
+        {
+            std::copy(sortedVectors.begin() + begin, sortedVectors.begin() + end, vectors + begin);
+        });
+    };
+
+    sortArray(points.GetPositions());
+    sortArray(points.GetNormals());
+
+    // The 3 color bytes of each point fit into the temporary vectors as well
+    byte *colors = points.GetColors();
+    byte *sortedColors = (byte*)sortedVectors.data();
+
+    scheduler->ParallelFor(vertexCount, [&](const int &chunk, const size_t &begin, const size_t &end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            std::copy(colors + 3 * indices[i], colors + 3 * indices[i] + 3, sortedColors + 3 * i);
+        }
+    });
+
+    scheduler->ParallelFor(vertexCount, [&](const int &chunk, const size_t &begin, const size_t &end)
+    {
+        std::copy(sortedColors + 3 * begin, sortedColors + 3 * end, colors + 3 * begin);
+    });
+
+    // Free the indices and the temporary copy before building the nodes
+    std::vector<UINT32>().swap(indices);
+    std::vector<Vector3>().swap(sortedVectors);
+
+    return arena->Create<OctreeNode>(0, &points, &mortonCodes[0], 0, vertexCount, center, size, depth, 1, arena, scheduler, progress);
+}
+
+void PointCloudEngine::Octree::Flatten(OctreeNode *root, const int &rootLevel, std::vector<FlatOctreeNode> &outNodes, std::vector<ClusteringStatistics> &outClusteringStatistics)
+{
+    // Breadth first order, the index in this vector plus the amount of nodes that are already in the output is the index in the flat node array
+    // Since all children of a node are appended at once they are consecutive and ordered by their child index
+    size_t firstIndex = outNodes.size();
+    std::vector<OctreeNode*> nodeOrder;
+    std::vector<int> nodeLevels;
+    nodeOrder.push_back(root);
+    nodeLevels.push_back(rootLevel);
+
+    for (size_t i = 0; i < nodeOrder.size(); i++)
+    {
+        OctreeNode *node = nodeOrder[i];
+        int level = nodeLevels[i];
+
+        // Collect the clustering statistics while the linked nodes still exist
+        if (level >= outClusteringStatistics.size())
+        {
+            outClusteringStatistics.resize(level + 1);
+        }
+
+        ClusteringStatistics &statistics = outClusteringStatistics[level];
+        statistics.nodeCount++;
+        statistics.iterations += node->clusteringIterations;
+        statistics.maxIterations = max(statistics.maxIterations, node->clusteringIterations);
+
+        if (node->clusteringIterations >= settings->kMeansMaxIterations)
+        {
+            statistics.cappedNodeCount++;
+        }
+
+        FlatOctreeNode flatNode;
+        flatNode.SetClusters(node->nodeVertex);
+        flatNode.childrenStart = firstIndex + nodeOrder.size();
+        flatNode.childrenMask = 0;
+
+        for (int j = 0; j < 8; j++)
+        {
+            if (node->children[j] != NULL)
+            {
+                flatNode.childrenMask |= 1 << j;
+                nodeOrder.push_back(node->children[j]);
+                nodeLevels.push_back(level + 1);
+            }
+        }
+
+        outNodes.push_back(flatNode);
+    }
+
+    outNodes.shrink_to_fit();
+}
+
+void PointCloudEngine::Octree::PushChildren(const FlatOctreeNode &node, const TraversalEntry &entry, const ViewFrustum &frustum)
+{
+    // The children are stored consecutively starting at the children start index
+    Vector3 childCenters[8];
+    int childCount = 0;
+
+    for (int i = 0; i < 8; i++)
+    {
+        if (node.childrenMask & (1 << i))
+        {
+            childCenters[childCount++] = OctreeNode::GetChildCenter(entry.position, entry.size, i);
+        }
+    }
+
+    int outsideMask = 0;
+    int insideMask = 0xFF;
+
+    if (!entry.inside)
+    {
+        frustum.TestCubes(childCenters, childCount, entry.size / 2.0f, outsideMask, insideMask);
+    }
+
+    for (int i = childCount - 1; i >= 0; i--)
+    {
+        if ((outsideMask & (1 << i)) == 0)
+        {
+            traversalStack.push_back({ node.childrenStart + i, childCenters[i], entry.size / 2.0f, entry.level - 1, (insideMask & (1 << i)) != 0 });
+        }
+    }
+}
+
+bool PointCloudEngine::Octree::IsDynamic()
+{
+    return !dynamicNodes.empty();
+}
+
+size_t PointCloudEngine::Octree::Insert(const std::vector<Vertex> &vertices)
+{
+    if (!IsDynamic())
+    {
+        ErrorMessage(L"Vertices can only be inserted into an octree that was built with dynamicOctree enabled", L"Insert", __FILEW__, __LINE__);
+        return 0;
+    }
+
+    // Grow the root first since this moves the root node and its children
+    std::vector<Vertex> acceptedVertices;
+    std::vector<Vertex> misplacedVertices;
+    std::vector<UINT32> changedLeaves;
+    acceptedVertices.reserve(vertices.size());
+
+    auto isInsideRoot = [&](const Vector3 &position)
+    {
+        Vector3 offset = position - rootPosition;
+        float halfSize = 0.5f * rootSize;
+
+        return (std::abs(offset.x) <= halfSize) && (std::abs(offset.y) <= halfSize) && (std::abs(offset.z) <= halfSize);
+    };
+
+    for (auto it = vertices.begin(); it != vertices.end(); it++)
+    {
+        // A NaN position is never inside of the root cube and would grow it forever
+        if (!std::isfinite(it->position.x) || !std::isfinite(it->position.y) || !std::isfinite(it->position.z))
+        {
+            continue;
+        }
+
+        // Each growth step doubles the root cube towards the position, don't grow it at all for outliers that are too far away
+        Vector3 offset = it->position - rootPosition;
+        float maxOffset = max(max(std::abs(offset.x), std::abs(offset.y)), std::abs(offset.z));
+
+        if (maxOffset > max(rootSize, FLT_EPSILON) * (float)(1 << MortonCode::maxDepth))
+        {
+            continue;
+        }
+
+        for (int growSteps = 0; !isInsideRoot(it->position) && (growSteps < MortonCode::maxDepth); growSteps++)
+        {
+            GrowRoot(it->position, misplacedVertices, changedLeaves);
+        }
+
+        if (isInsideRoot(it->position))
+        {
+            acceptedVertices.push_back(*it);
+        }
+    }
+
+    for (int i = 0; i < 2; i++)
+    {
+        const std::vector<Vertex> &insertedVertices = (i == 0) ? acceptedVertices : misplacedVertices;
+
+        for (auto it = insertedVertices.begin(); it != insertedVertices.end(); it++)
+        {
+            UINT32 leaf = FindLeaf(it->position, true);
+            dynamicNodes[leaf].vertices.push_back(*it);
+
+            if (changedLeaves.empty() || (changedLeaves.back() != leaf))
+            {
+                changedLeaves.push_back(leaf);
+            }
+        }
+    }
+
+    UpdateNodes(changedLeaves);
+
+    return acceptedVertices.size();
+}
+
+size_t PointCloudEngine::Octree::Remove(const std::vector<Vertex> &vertices)
+{
+    if (!IsDynamic())
+    {
+        ErrorMessage(L"Vertices can only be removed from an octree that was built with dynamicOctree enabled", L"Remove", __FILEW__, __LINE__);
+        return 0;
+    }
+
+    std::vector<UINT32> changedLeaves;
+    size_t removedCount = 0;
+
+    for (auto it = vertices.begin(); it != vertices.end(); it++)
+    {
+        UINT32 leaf = FindLeaf(it->position, false);
+
+        if (leaf == invalidIndex)
+        {
+            continue;
+        }
+
+        // The order of the leaf vertices doesn't matter, replace the removed vertex with the last one
+        std::vector<Vertex> &leafVertices = dynamicNodes[leaf].vertices;
+
+        for (size_t i = 0; i < leafVertices.size(); i++)
+        {
+            if (leafVertices[i].position == it->position)
+            {
+                leafVertices[i] = leafVertices.back();
+                leafVertices.pop_back();
+                changedLeaves.push_back(leaf);
+                removedCount++;
+                break;
+            }
+        }
+    }
+
+    UpdateNodes(changedLeaves);
+
+    return removedCount;
+}
+
+size_t PointCloudEngine::Octree::RemoveBox(const Vector3 &boxMin, const Vector3 &boxMax)
+{
+    if (!IsDynamic())
+    {
+        ErrorMessage(L"Vertices can only be removed from an octree that was built with dynamicOctree enabled", L"RemoveBox", __FILEW__, __LINE__);
+        return 0;
+    }
+
+    // Only visit the nodes whose cube intersects the box
+    std::vector<UINT32> changedLeaves;
+    std::vector<UINT32> stack;
+    stack.push_back(0);
+    size_t removedCount = 0;
+
+    while (!stack.empty())
+    {
+        UINT32 index = stack.back();
+        stack.pop_back();
+
+        const FlatOctreeNode &node = nodes[index];
+        const DynamicNode &dynamicNode = dynamicNodes[index];
+        Vector3 halfSize = Vector3(0.5f * dynamicNode.size);
+        Vector3 nodeMin = dynamicNode.center - halfSize;
+        Vector3 nodeMax = dynamicNode.center + halfSize;
+
+        if ((nodeMax.x < boxMin.x) || (nodeMax.y < boxMin.y) || (nodeMax.z < boxMin.z) || (nodeMin.x > boxMax.x) || (nodeMin.y > boxMax.y) || (nodeMin.z > boxMax.z))
+        {
+            continue;
+        }
+
+        if (node.childrenMask == 0)
+        {
+            std::vector<Vertex> &leafVertices = dynamicNodes[index].vertices;
+            size_t vertexCount = leafVertices.size();
+
+            leafVertices.erase(std::remove_if(leafVertices.begin(), leafVertices.end(), [&](const Vertex &v)
+            {
+                return (v.position.x >= boxMin.x) && (v.position.y >= boxMin.y) && (v.position.z >= boxMin.z) && (v.position.x <= boxMax.x) && (v.position.y <= boxMax.y) && (v.position.z <= boxMax.z);
+            }), leafVertices.end());
+
+            if (leafVertices.size() < vertexCount)
+            {
+                removedCount += vertexCount - leafVertices.size();
+                changedLeaves.push_back(index);
+            }
+        }
+        else
+        {
+            UINT32 childIndex = node.childrenStart;
+
+            for (int i = 0; i < 8; i++)
+            {
+                if (node.childrenMask & (1 << i))
+                {
+                    stack.push_back(childIndex++);
+                }
+            }
+        }
+    }
+
+    UpdateNodes(changedLeaves);
+
+    return removedCount;
+}
+
+void PointCloudEngine::Octree::InitializeDynamicNodes(const PointBuffer &points, const int &depth, TaskScheduler *scheduler)
+{
+    dynamicNodes.resize(nodes.size());
+    dynamicNodes[0].depth = depth;
+    dynamicNodes[0].center = rootPosition;
+    dynamicNodes[0].size = rootSize;
+
+    // Parents are always before their children in breadth first order
+    for (UINT32 i = 0; i < nodes.size(); i++)
+    {
+        UINT32 childIndex = nodes[i].childrenStart;
+
+        for (int j = 0; j < 8; j++)
+        {
+            if (nodes[i].childrenMask & (1 << j))
+            {
+                dynamicNodes[childIndex].parent = i;
+                dynamicNodes[childIndex].depth = dynamicNodes[i].depth - 1;
+                dynamicNodes[childIndex].center = OctreeNode::GetChildCenter(dynamicNodes[i].center, dynamicNodes[i].size, j);
+                dynamicNodes[childIndex].size = dynamicNodes[i].size / 2.0f;
+                childIndex++;
+            }
+        }
+    }
+
+    // The morton builder can put vertices exactly on a cube boundary into the other child, these are inserted afterwards
+    std::vector<Vertex> remainingVertices;
+
+    for (size_t i = 0; i < points.GetCount(); i++)
+    {
+        UINT32 leaf = FindLeaf(points.GetPositions()[i], false);
+
+        if (leaf != invalidIndex)
+        {
+            dynamicNodes[leaf].vertices.push_back(points.GetVertex(i));
+        }
+        else
+        {
+            remainingVertices.push_back(points.GetVertex(i));
+        }
+    }
+
+    // Only calculate the cluster summaries, the node vertices stay the same as they were built
+    scheduler->ParallelFor(nodes.size(), [&](const int &chunk, const size_t &begin, const size_t &end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            if ((nodes[i].childrenMask == 0) && !dynamicNodes[i].vertices.empty())
+            {
+                OctreeNode::CalculateClusterSummaries(&dynamicNodes[i].vertices[0], dynamicNodes[i].vertices.size(), dynamicNodes[i].clusterSummaries);
+            }
+        }
+    });
+
+    for (UINT32 i = nodes.size(); i-- > 0;)
+    {
+        if (nodes[i].childrenMask != 0)
+        {
+            ClusterSummary childSummaries[48];
+            int childClusterCount = 0;
+            UINT32 childIndex = nodes[i].childrenStart;
+
+            for (int j = 0; j < 8; j++)
+            {
+                if (nodes[i].childrenMask & (1 << j))
+                {
+                    std::copy(dynamicNodes[childIndex].clusterSummaries, dynamicNodes[childIndex].clusterSummaries + 6, childSummaries + childClusterCount);
+                    childClusterCount += 6;
+                    childIndex++;
+                }
+            }
+
+            OctreeNode::MergeClusterSummaries(childSummaries, childClusterCount, dynamicNodes[i].clusterSummaries);
+        }
+    }
+
+    if (!remainingVertices.empty())
+    {
+        Insert(remainingVertices);
+    }
+}
+
+void PointCloudEngine::Octree::GrowRoot(const Vector3 &position, std::vector<Vertex> &outMisplacedVertices, std::vector<UINT32> &outChangedLeaves)
+{
+    // The new root is twice as large and extends towards the position, the old root becomes one of its children
+    FlatOctreeNode oldRoot = nodes[0];
+    Vector3 center = rootPosition;
+    float size = max(rootSize, FLT_EPSILON);
+
+    Vector3 direction((position.x > center.x) ? 1.0f : -1.0f, (position.y > center.y) ? 1.0f : -1.0f, (position.z > center.z) ? 1.0f : -1.0f);
+    Vector3 newCenter = center + 0.5f * size * direction;
+    int childIndex = OctreeNode::GetChildIndex(newCenter, center);
+
+    UINT32 movedIndex = nodes.size();
+    nodes.push_back(oldRoot);
+    dynamicNodes.push_back(std::move(dynamicNodes[0]));
+    dynamicNodes[movedIndex].parent = 0;
+
+    UINT32 grandchildIndex = oldRoot.childrenStart;
+
+    for (int i = 0; i < 8; i++)
+    {
+        if (oldRoot.childrenMask & (1 << i))
+        {
+            dynamicNodes[grandchildIndex++].parent = movedIndex;
+        }
+    }
+
+    nodes[0].childrenStart = movedIndex;
+    nodes[0].childrenMask = 1 << childIndex;
+
+    // An old root with size 0 grows to epsilon as well, otherwise its cube and the cubes below would not match the implicit cubes of the new root
+    if (rootSize != size)
+    {
+        std::vector<UINT32> resizeStack = { movedIndex };
+        dynamicNodes[movedIndex].size = size;
+
+        while (!resizeStack.empty())
+        {
+            UINT32 index = resizeStack.back();
+            resizeStack.pop_back();
+
+            UINT32 childNodeIndex = nodes[index].childrenStart;
+
+            for (int i = 0; i < 8; i++)
+            {
+                if (nodes[index].childrenMask & (1 << i))
+                {
+                    dynamicNodes[childNodeIndex].center = OctreeNode::GetChildCenter(dynamicNodes[index].center, dynamicNodes[index].size, i);
+                    dynamicNodes[childNodeIndex].size = dynamicNodes[index].size / 2.0f;
+                    resizeStack.push_back(childNodeIndex++);
+                }
+            }
+        }
+    }
+
+    rootPosition = newCenter;
+    rootSize = 2.0f * size;
+
+    dynamicNodes[0] = DynamicNode();
+    dynamicNodes[0].depth = dynamicNodes[movedIndex].depth + 1;
+    dynamicNodes[0].center = rootPosition;
+    dynamicNodes[0].size = rootSize;
+    std::copy(dynamicNodes[movedIndex].clusterSummaries, dynamicNodes[movedIndex].clusterSummaries + 6, dynamicNodes[0].clusterSummaries);
+
+    // Vertices exactly on the minimum side of the old root cube (or rounded beyond it) now belong to another child of the new root
+    // Only the nodes that touch the new center planes are searched, the misplaced vertices are removed and inserted again
+    float tolerance = 0.001f * size;
+    std::vector<UINT32> stack;
+    stack.push_back(movedIndex);
+
+    while (!stack.empty())
+    {
+        UINT32 index = stack.back();
+        stack.pop_back();
+
+        const FlatOctreeNode &node = nodes[index];
+        Vector3 offset = dynamicNodes[index].center - newCenter;
+        float halfSize = 0.5f * dynamicNodes[index].size + tolerance;
+
+        if ((std::abs(offset.x) > halfSize) && (std::abs(offset.y) > halfSize) && (std::abs(offset.z) > halfSize))
+        {
+            continue;
+        }
+
+        if (node.childrenMask == 0)
+        {
+            std::vector<Vertex> &leafVertices = dynamicNodes[index].vertices;
+            size_t vertexCount = leafVertices.size();
+
+            for (size_t i = 0; i < leafVertices.size();)
+            {
+                if (OctreeNode::GetChildIndex(newCenter, leafVertices[i].position) != childIndex)
+                {
+                    outMisplacedVertices.push_back(leafVertices[i]);
+                    leafVertices[i] = leafVertices.back();
+                    leafVertices.pop_back();
+                }
+                else
+                {
+                    i++;
+                }
+            }
+
+            if (leafVertices.size() < vertexCount)
+            {
+                outChangedLeaves.push_back(index);
+            }
+        }
+        else
+        {
+            UINT32 childNodeIndex = node.childrenStart;
+
+            for (int i = 0; i < 8; i++)
+            {
+                if (node.childrenMask & (1 << i))
+                {
+                    stack.push_back(childNodeIndex++);
+                }
+            }
+        }
+    }
+}
+
+UINT32 PointCloudEngine::Octree::Resolve(UINT32 index)
+{
+    while (dynamicNodes[index].movedTo != invalidIndex)
+    {
+        index = dynamicNodes[index].movedTo;
+    }
+
+    return index;
+}
+
+UINT32 PointCloudEngine::Octree::GetChildNodeIndex(const UINT32 &index, const int &childIndex)
+{
+    const FlatOctreeNode &node = nodes[index];
+
+    if (!(node.childrenMask & (1 << childIndex)))
+    {
+        return invalidIndex;
+    }
+
+    // Skip the children with a smaller child index
+    UINT32 childNodeIndex = node.childrenStart;
+
+    for (int i = 0; i < childIndex; i++)
+    {
+        if (node.childrenMask & (1 << i))
+        {
+            childNodeIndex++;
+        }
+    }
+
+    return childNodeIndex;
+}
+
+UINT32 PointCloudEngine::Octree::FindLeaf(const Vector3 &position, const bool &create)
+{
+    UINT32 index = 0;
+
+    while (nodes[index].childrenMask != 0)
+    {
+        int childIndex = OctreeNode::GetChildIndex(dynamicNodes[index].center, position);
+
+        if (!(nodes[index].childrenMask & (1 << childIndex)))
+        {
+            if (!create)
+            {
+                return invalidIndex;
+            }
+
+            // Add an empty leaf, the caller fills it with vertices
+            SetChildrenMask(index, nodes[index].childrenMask | (1 << childIndex));
+        }
+
+        index = GetChildNodeIndex(index, childIndex);
+    }
+
+    return index;
+}
+
+void PointCloudEngine::Octree::SetChildrenMask(const UINT32 &index, const byte &childrenMask)
+{
+    // The children have to be consecutive, therefore the changed set of children is copied to the end of the node array
+    // Children that are not in the new mask anymore must be leaves, the old slots are unused until the nodes are compacted
+    FlatOctreeNode node = nodes[index];
+    UINT32 oldChildIndex = node.childrenStart;
+    UINT32 newChildrenStart = nodes.size();
+
+    for (int i = 0; i < 8; i++)
+    {
+        bool oldChild = node.childrenMask & (1 << i);
+        bool newChild = childrenMask & (1 << i);
+
+        if (oldChild)
+        {
+            unusedNodeCount++;
+        }
+
+        if (oldChild && newChild)
+        {
+            UINT32 movedIndex = nodes.size();
+            nodes.push_back(nodes[oldChildIndex]);
+            dynamicNodes.push_back(std::move(dynamicNodes[oldChildIndex]));
+            dynamicNodes[oldChildIndex].movedTo = movedIndex;
+
+            UINT32 grandchildIndex = nodes[movedIndex].childrenStart;
+
+            for (int j = 0; j < 8; j++)
+            {
+                if (nodes[movedIndex].childrenMask & (1 << j))
+                {
+                    dynamicNodes[grandchildIndex++].parent = movedIndex;
+                }
+            }
+        }
+        else if (newChild)
+        {
+            FlatOctreeNode child;
+            ZeroMemory(&child, sizeof(FlatOctreeNode));
+
+            DynamicNode dynamicChild;
+            dynamicChild.parent = index;
+            dynamicChild.depth = dynamicNodes[index].depth - 1;
+            dynamicChild.center = OctreeNode::GetChildCenter(dynamicNodes[index].center, dynamicNodes[index].size, i);
+            dynamicChild.size = dynamicNodes[index].size / 2.0f;
+
+            nodes.push_back(child);
+            dynamicNodes.push_back(std::move(dynamicChild));
+        }
+        else if (oldChild)
+        {
+            dynamicNodes[oldChildIndex].parent = invalidIndex;
+            dynamicNodes[oldChildIndex].vertices = std::vector<Vertex>();
+        }
+
+        if (oldChild)
+        {
+            oldChildIndex++;
+        }
+    }
+
+    nodes[index].childrenStart = newChildrenStart;
+    nodes[index].childrenMask = childrenMask;
+}
+
+void PointCloudEngine::Octree::Split(const UINT32 &index)
+{
+    // Distribute the leaf vertices into new child leaves and split these again if required
+    std::vector<Vertex> vertices;
+    vertices.swap(dynamicNodes[index].vertices);
+
+    Vector3 center = dynamicNodes[index].center;
+    std::vector<Vertex> childVertices[8];
+    byte childrenMask = 0;
+
+    for (auto it = vertices.begin(); it != vertices.end(); it++)
+    {
+        int childIndex = OctreeNode::GetChildIndex(center, it->position);
+        childVertices[childIndex].push_back(*it);
+        childrenMask |= 1 << childIndex;
+    }
+
+    std::vector<Vertex>().swap(vertices);
+    SetChildrenMask(index, childrenMask);
+
+    // The new children are leaves, splitting them only appends their own children to the node array
+    for (int i = 0; i < 8; i++)
+    {
+        if (childrenMask & (1 << i))
+        {
+            UINT32 childNodeIndex = GetChildNodeIndex(index, i);
+            dynamicNodes[childNodeIndex].vertices.swap(childVertices[i]);
+
+            if (OctreeNode::IsSubdivided(dynamicNodes[childNodeIndex].vertices.size(), dynamicNodes[childNodeIndex].size, dynamicNodes[childNodeIndex].depth))
+            {
+                Split(childNodeIndex);
+            }
+            else
+            {
+                UpdateClusters(childNodeIndex);
+            }
+        }
+    }
+
+    UpdateClusters(index);
+}
+
+void PointCloudEngine::Octree::Collapse(const UINT32 &index)
+{
+    std::vector<Vertex> vertices;
+    CollectVertices(index, vertices);
+
+    nodes[index].childrenMask = 0;
+    dynamicNodes[index].vertices.swap(vertices);
+}
+
+void PointCloudEngine::Octree::CollectVertices(const UINT32 &index, std::vector<Vertex> &outVertices)
+{
+    // Moves the vertices of all the leaves below this node into the output, the nodes below become unused
+    UINT32 childIndex = nodes[index].childrenStart;
+
+    for (int i = 0; i < 8; i++)
+    {
+        if (nodes[index].childrenMask & (1 << i))
+        {
+            if (nodes[childIndex].childrenMask == 0)
+            {
+                std::vector<Vertex> &childVertices = dynamicNodes[childIndex].vertices;
+                outVertices.insert(outVertices.end(), childVertices.begin(), childVertices.end());
+                std::vector<Vertex>().swap(childVertices);
+            }
+            else
+            {
+                CollectVertices(childIndex, outVertices);
+            }
+
+            dynamicNodes[childIndex].parent = invalidIndex;
+            unusedNodeCount++;
+            childIndex++;
+        }
+    }
+}
+
+void PointCloudEngine::Octree::UpdateClusters(const UINT32 &index)
+{
+    DynamicNode &dynamicNode = dynamicNodes[index];
+
+    if (nodes[index].childrenMask == 0)
+    {
+        if (dynamicNode.vertices.empty())
+        {
+            std::fill(dynamicNode.clusterSummaries, dynamicNode.clusterSummaries + 6, ClusterSummary());
+        }
+        else
+        {
+            OctreeNode::CalculateClusterSummaries(&dynamicNode.vertices[0], dynamicNode.vertices.size(), dynamicNode.clusterSummaries);
+        }
+    }
+    else
+    {
+        // Same as the bottom up clustering mode, k-means on all the vertices of a large inner node would be too slow for interactive updates
+        ClusterSummary childSummaries[48];
+        int childClusterCount = 0;
+        UINT32 childIndex = nodes[index].childrenStart;
+
+        for (int i = 0; i < 8; i++)
+        {
+            if (nodes[index].childrenMask & (1 << i))
+            {
+                std::copy(dynamicNodes[childIndex].clusterSummaries, dynamicNodes[childIndex].clusterSummaries + 6, childSummaries + childClusterCount);
+                childClusterCount += 6;
+                childIndex++;
+            }
+        }
+
+        OctreeNode::MergeClusterSummaries(childSummaries, childClusterCount, dynamicNode.clusterSummaries);
+    }
+
+    OctreeNodeVertex nodeVertex;
+    OctreeNode::AssignClusters(dynamicNode.clusterSummaries, nodeVertex);
+    nodes[index].SetClusters(nodeVertex);
+}
+
+void PointCloudEngine::Octree::UpdateNodes(const std::vector<UINT32> &changedLeaves)
+{
+    // Nodes with the smallest remaining depth are updated first, therefore all the children of a node are updated before the node itself
+    // The indices can become outdated when a sibling is added or removed, they are resolved when the node is updated
+    std::set<std::pair<int, UINT32>> dirtyNodes;
+
+    for (auto it = changedLeaves.begin(); it != changedLeaves.end(); it++)
+    {
+        dirtyNodes.insert(std::make_pair(dynamicNodes[*it].depth, *it));
+    }
+
+    while (!dirtyNodes.empty())
+    {
+        UINT32 index = Resolve(dirtyNodes.begin()->second);
+        dirtyNodes.erase(dirtyNodes.begin());
+
+        UINT32 parent = dynamicNodes[index].parent;
+
+        // Skip removed nodes, the root is the only node without a parent
+        if ((index != 0) && (parent == invalidIndex))
+        {
+            continue;
+        }
+
+        if (nodes[index].childrenMask == 0)
+        {
+            size_t vertexCount = dynamicNodes[index].vertices.size();
+
+            if ((vertexCount == 0) && (index != 0))
+            {
+                // Remove the empty leaf, the parent becomes an empty leaf as well if this was its last child
+                int childIndex = OctreeNode::GetChildIndex(dynamicNodes[parent].center, dynamicNodes[index].center);
+                SetChildrenMask(parent, nodes[parent].childrenMask & ~(1 << childIndex));
+            }
+            else if (OctreeNode::IsSubdivided(vertexCount, dynamicNodes[index].size, dynamicNodes[index].depth))
+            {
+                Split(index);
+            }
+            else
+            {
+                UpdateClusters(index);
+            }
+        }
+        else
+        {
+            // The children are already updated, in the adaptive mode a subtree with few vertices becomes a single leaf again
+            UINT64 vertexCount = 0;
+            UINT32 childIndex = nodes[index].childrenStart;
+
+            for (int i = 0; i < 8; i++)
+            {
+                if (nodes[index].childrenMask & (1 << i))
+                {
+                    for (int j = 0; j < 6; j++)
+                    {
+                        vertexCount += dynamicNodes[childIndex].clusterSummaries[j].count;
+                    }
+
+                    childIndex++;
+                }
+            }
+
+            if (!OctreeNode::IsSubdivided(vertexCount, dynamicNodes[index].size, dynamicNodes[index].depth))
+            {
+                Collapse(index);
+            }
+
+            UpdateClusters(index);
+        }
+
+        if (index != 0)
+        {
+            dirtyNodes.insert(std::make_pair(dynamicNodes[parent].depth, parent));
+        }
+    }
+
+    if (unusedNodeCount > nodes.size() / 2)
+    {
+        CompactNodes();
+    }
+}
+
+void PointCloudEngine::Octree::CompactNodes()
+{
+    // Copy the used nodes in breadth first order, the same order as a newly built octree
+    std::vector<FlatOctreeNode> compactNodes;
+    std::vector<DynamicNode> compactDynamicNodes;
+    compactNodes.reserve(nodes.size() - unusedNodeCount);
+    compactDynamicNodes.reserve(nodes.size() - unusedNodeCount);
+
+    compactNodes.push_back(nodes[0]);
+    compactDynamicNodes.push_back(std::move(dynamicNodes[0]));
+
+    for (UINT32 i = 0; i < compactNodes.size(); i++)
+    {
+        UINT32 childIndex = compactNodes[i].childrenStart;
+        compactNodes[i].childrenStart = compactNodes.size();
+
+        for (int j = 0; j < 8; j++)
+        {
+            if (compactNodes[i].childrenMask & (1 << j))
+            {
+                compactNodes.push_back(nodes[childIndex]);
+                compactDynamicNodes.push_back(std::move(dynamicNodes[childIndex]));
+                compactDynamicNodes.back().parent = i;
+                childIndex++;
+            }
+        }
+    }
+
+    nodes.swap(compactNodes);
+    dynamicNodes.swap(compactDynamicNodes);
+    unusedNodeCount = 0;
+}
@@ -9,15 +9,134 @@ namespace PointCloudEngine
     class Octree
     {
     public:
-        Octree(const std::vector<Vertex> &vertices, const int &depth);
+        // The builders reorder the points in place instead of converting them into the vertex format, move the points in to avoid copying them
+        // The progress is optional and allows to cancel a build that runs on another thread
+        Octree(PointBuffer points, const int &depth, BuildProgress *progress = NULL);
+
+        // Upper estimate of the memory that building from points needs at once, the points and the temporary arrays of the builder
+        // The linked nodes are not part of it, there are much less of them than points
+        static UINT64 GetBuildMemorySize(const UINT64 &vertexCount);
+
+        // Builds the octree directly from the ply file with the out-of-core builder, the vertices are never all in memory at once
+        Octree(const std::wstring &plyfile, const int &depth, BuildProgress *progress = NULL);
+
+        // Uses the nodes of a valid cache in place or streams them, the octree owns the cache afterwards
+        Octree(OctreeCache *cache);
         ~Octree();
 
-        std::vector<OctreeNodeVertex> GetVertices(const Vector3 &localCameraPosition, const float &splatSize);
-        std::vector<OctreeNodeVertex> GetVerticesAtLevel(const int &level);
+        // Writes the nodes into the cache file of the ply file, the next time the file is opened they are loaded from there
+        bool WriteCache(const std::wstring &plyfile, const int &depth, const UINT64 &vertexCount);
+
+        // The traversals clear the buffer and append the vertices of the cut, the buffer and the traversal stack keep their capacity
+        // Passing the same buffer every frame means that steady state frames don't allocate any memory
+        // Nodes outside of the frustum are skipped with their whole subtree, the frustum has to be in the same local space as the camera position
+        void GetVertices(const Vector3 &localCameraPosition, const ViewFrustum &frustum, const float &splatSize, std::vector<OctreeNodeVertex> &outVertices);
+        void GetVerticesAtLevel(const int &level, std::vector<OctreeNodeVertex> &outVertices);
         void GetRootPositionAndSize(Vector3 &outRootPosition, float &outSize);
+        size_t GetNodeCount();
+
+        // Format of the cluster colors, settings->colorFormat when the octree was built
+        ColorFormat GetColorFormat();
+
+        // Clustering iterations of the nodes at each level, the root level is the first one
+        std::vector<ClusteringStatistics> GetClusteringStatistics();
+
+        // FNV-1a hash of the node vertices and children masks in breadth first order, the padding and the child indices are not part of it
+        // The build is deterministic, the same vertices and settings give the same hash with any thread count
+        UINT64 GetHash();
+
+        // Appends the linked nodes below the root in breadth first order, the root node has this level in the statistics
+        static void Flatten(OctreeNode *root, const int &rootLevel, std::vector<FlatOctreeNode> &outNodes, std::vector<ClusteringStatistics> &outClusteringStatistics);
+
+        // Only available when the octree was built with settings->dynamicOctree, only the changed leaves and their ancestors are updated
+        // Inserting splits leaves that have too many vertices and grows the root cube if the vertices are outside of it
+        // Vertices with non-finite positions or further away than the root cube grown MortonCode::maxDepth times are skipped, returns the inserted count
+        // Removing matches the exact vertex positions, empty nodes are removed and adaptive subtrees with few vertices are collapsed
+        bool IsDynamic();
+        size_t Insert(const std::vector<Vertex> &vertices);
+        size_t Remove(const std::vector<Vertex> &vertices);
+        size_t RemoveBox(const Vector3 &boxMin, const Vector3 &boxMax);
 
     private:
-        OctreeNode *root = NULL;
+        static const UINT32 invalidIndex = 0xFFFFFFFF;
+
+        // Additional data of each flat node with the same index, only stored for dynamic octrees
+        struct DynamicNode
+        {
+            UINT32 parent = invalidIndex;
+
+            // Remaining subdivision depth, the root has the largest depth
+            int depth = 0;
+
+            // The flat nodes don't store their cube, the updates need it for every node
+            Vector3 center;
+            float size = 0;
+
+            // Set when the node was copied to the end of the node array, the old slot is unused until the nodes are compacted
+            UINT32 movedTo = invalidIndex;
+
+            ClusterSummary clusterSummaries[6];
+
+            // Only the leaves store their vertices
+            std::vector<Vertex> vertices;
+        };
+
+        // Node of the flat array and its cube, the level counts down to the requested level of GetVerticesAtLevel
+        struct TraversalEntry
+        {
+            UINT32 index;
+            Vector3 position;
+            float size;
+            int level;
+
+            // Set when the cube is completely inside of the frustum, its children are not tested again
+            bool inside;
+        };
+
+        // Node of the cache or the node vector, streamed nodes stay valid until the traversal is finished
+        const FlatOctreeNode& GetNode(const UINT32 &index);
+
+        // Sorts the points by their morton codes in place before building the nodes
+        OctreeNode* BuildMorton(PointBuffer &points, const Vector3 &center, const float &size, const int &depth, MemoryArena *arena, TaskScheduler *scheduler, BuildProgress *progress);
+
+        // Pushes the children in reverse order, they are popped in the same order as a recursive traversal visits them
+        // Children outside of the frustum are not pushed, all the children of a node are tested together
+        void PushChildren(const FlatOctreeNode &node, const TraversalEntry &entry, const ViewFrustum &frustum);
+
+        // Dynamic octree helpers, node indices change when children are added or removed, moved nodes are found with Resolve
+        void InitializeDynamicNodes(const PointBuffer &points, const int &depth, TaskScheduler *scheduler);
+        void GrowRoot(const Vector3 &position, std::vector<Vertex> &outMisplacedVertices, std::vector<UINT32> &outChangedLeaves);
+        UINT32 Resolve(UINT32 index);
+        UINT32 GetChildNodeIndex(const UINT32 &index, const int &childIndex);
+        UINT32 FindLeaf(const Vector3 &position, const bool &create);
+        void SetChildrenMask(const UINT32 &index, const byte &childrenMask);
+        void Split(const UINT32 &index);
+        void Collapse(const UINT32 &index);
+        void UpdateClusters(const UINT32 &index);
+        void CollectVertices(const UINT32 &index, std::vector<Vertex> &outVertices);
+        void UpdateNodes(const std::vector<UINT32> &changedLeaves);
+        void CompactNodes();
+
+        // All the nodes in breadth first order, the root node is the first one
+        // An octree without nodes is the result of a failed or cancelled out-of-core build
+        std::vector<FlatOctreeNode> nodes;
+
+        // The cubes of all the other nodes are calculated from the root cube during the traversal
+        Vector3 rootPosition;
+        float rootSize = 0;
+        ColorFormat colorFormat = ColorFormat::RGB664;
+
+        std::vector<ClusteringStatistics> clusteringStatistics;
+
+        // Explicit stack of the traversals, holds at most 7 entries per level plus the root
+        std::vector<TraversalEntry> traversalStack;
+
+        // Only set when the octree was loaded from a cache, the node vector is empty then
+        OctreeCache *cache = NULL;
+
+        // Empty when the octree is not dynamic
+        std::vector<DynamicNode> dynamicNodes;
+        size_t unusedNodeCount = 0;
     };
 }
 
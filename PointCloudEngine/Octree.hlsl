@@ -12,11 +12,10 @@ cbuffer OctreeRendererConstantBuffer : register(b0)
     float fovAngleY;
 //------------------------------------------------------------------------------ (16 byte boundary)
     float splatSize;
-    // 12 bytes auto padding
+    uint colorFormat;
+    // 8 bytes auto padding
 };  // Total: 288 bytes with constant buffer packing rules
 
-static const float PI = 3.141592654f;
-
 struct VS_INPUT
 {
     float3 position : POSITION;
@@ -41,26 +40,49 @@ struct VS_INPUT
     float size : SIZE;
 };
 
-float3 PolarNormalToFloat3(uint theta, uint phi)
+float3 OctahedralNormalToFloat3(uint x, uint y)
 {
-    if (theta == 0 && phi == 0)
+    // Same decoding as OctahedralNormal::ToVector3, x=0 and y=0 is the empty normal
+    if (x == 0 && y == 0)
     {
         return float3(0, 0, 0);
     }
 
-    float t = PI * (theta / 255.0f);
-    float p = PI * ((phi / 127.5f) - 1.0f);
+    float2 uv = float2(x, y) / 127.5f - 1.0f;
+    float3 normal = float3(uv, 1.0f - abs(uv.x) - abs(uv.y));
 
-    return float3(sin(t) * cos(p), sin(t) * sin(p), cos(t));
+    if (normal.z < 0)
+    {
+        normal.xy = (1.0f - abs(uv.yx)) * (uv >= 0 ? 1.0f : -1.0f);
+    }
+
+    return normalize(normal);
 }
 
-float3 PolarNormalToFloat3(uint2 polarNormal)
+float3 OctahedralNormalToFloat3(uint2 octahedralNormal)
 {
-    return PolarNormalToFloat3(polarNormal.x, polarNormal.y);
+    return OctahedralNormalToFloat3(octahedralNormal.x, octahedralNormal.y);
 }
 
 float3 Color16ToFloat3(uint color)
 {
+    // Same decoding as ColorCodec::Decode for each ColorFormat
+    if (colorFormat == 1)
+    {
+        // RGB565
+        return float3(((color >> 11) & 31) / 31.0f, ((color >> 5) & 63) / 63.0f, (color & 31) / 31.0f);
+    }
+    else if (colorFormat == 2)
+    {
+        // YCoCg655, Co is red minus blue and Cg is green minus the average of red and blue
+        float y = ((color >> 10) & 63) / 63.0f;
+        float co = 2.0f * (((color >> 5) & 31) / 31.0f) - 1.0f;
+        float cg = 2.0f * ((color & 31) / 31.0f) - 1.0f;
+
+        return saturate(float3(y + 0.5f * co - 0.5f * cg, y + 0.5f * cg, y - 0.5f * co - 0.5f * cg));
+    }
+
+    // RGB664
     float r = ((color >> 10) & 63) / 63.0f;
     float g = ((color >> 4) & 63) / 63.0f;
     float b = (color & 15) / 15.0f;
@@ -0,0 +1,474 @@
+#include "OctreeCache.h"
+
+#define OCTREECACHE_MAGIC "PCEOCTR"
+
+PointCloudEngine::OctreeCache::OctreeCache(const std::wstring &plyfile, const int &depth)
+{
+    ZeroMemory(&header, sizeof(Header));
+    file = CreateFileW(GetCacheFilename(plyfile).c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return;
+    }
+
+    LARGE_INTEGER fileSize;
+
+    if (!GetFileSizeEx(file, &fileSize) || !Read(0, &header, sizeof(Header)))
+    {
+        return;
+    }
+
+    if ((memcmp(header.magic, OCTREECACHE_MAGIC, sizeof(header.magic)) != 0) || (header.checksum != GetChecksum(header)))
+    {
+        return;
+    }
+
+    if ((header.version != version) || (header.nodeSize != sizeof(FlatOctreeNode)) || (header.key != GetKey(plyfile, depth)))
+    {
+        return;
+    }
+
+    UINT64 nodeBytes = header.nodeCount * sizeof(FlatOctreeNode);
+
+    if ((header.nodeCount == 0) || ((UINT64)fileSize.QuadPart != GetNodesOffset() + nodeBytes))
+    {
+        return;
+    }
+
+    pages.resize(header.pageCount);
+
+    if (!Read(sizeof(Header) + header.clusteringStatisticsCount * sizeof(ClusteringStatistics), pages.data(), pages.size() * sizeof(Page)))
+    {
+        return;
+    }
+
+    // The pages have to cover all the nodes without gaps for the binary search in GetNode
+    UINT64 nextNode = 0;
+
+    for (auto it = pages.begin(); it != pages.end(); it++)
+    {
+        if ((it->firstNode != nextNode) || (it->nodeCount == 0))
+        {
+            return;
+        }
+
+        nextNode += it->nodeCount;
+    }
+
+    if (nextNode != header.nodeCount)
+    {
+        return;
+    }
+
+    maxResidentBytes = (size_t)max(1, settings->octreePageBudget) * 1024 * 1024;
+
+    if (nodeBytes > maxResidentBytes)
+    {
+        residentPages.resize(pages.size());
+    }
+    else
+    {
+        // Only the pages with the nodes are loaded by the operating system when they are accessed
+        mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+        if (mapping == NULL)
+        {
+            return;
+        }
+
+        view = (const byte*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+        if (view == NULL)
+        {
+            return;
+        }
+
+        mappedNodes = (const FlatOctreeNode*)(view + GetNodesOffset());
+    }
+
+    valid = true;
+}
+
+PointCloudEngine::OctreeCache::~OctreeCache()
+{
+    if (view != NULL)
+    {
+        UnmapViewOfFile(view);
+    }
+
+    if (mapping != NULL)
+    {
+        CloseHandle(mapping);
+    }
+
+    if (file != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(file);
+    }
+}
+
+bool PointCloudEngine::OctreeCache::IsValid()
+{
+    return valid;
+}
+
+bool PointCloudEngine::OctreeCache::IsStreamed()
+{
+    return mappedNodes == NULL;
+}
+
+size_t PointCloudEngine::OctreeCache::GetNodeCount()
+{
+    return header.nodeCount;
+}
+
+std::vector<ClusteringStatistics> PointCloudEngine::OctreeCache::GetClusteringStatistics()
+{
+    std::vector<ClusteringStatistics> clusteringStatistics(header.clusteringStatisticsCount);
+    Read(sizeof(Header), clusteringStatistics.data(), clusteringStatistics.size() * sizeof(ClusteringStatistics));
+
+    return clusteringStatistics;
+}
+
+UINT64 PointCloudEngine::OctreeCache::GetVertexCount()
+{
+    return header.vertexCount;
+}
+
+void PointCloudEngine::OctreeCache::GetRootPositionAndSize(Vector3 &outRootPosition, float &outSize)
+{
+    outRootPosition = header.rootPosition;
+    outSize = header.rootSize;
+}
+
+const PointCloudEngine::FlatOctreeNode& PointCloudEngine::OctreeCache::GetNode(const UINT32 &index)
+{
+    if (mappedNodes != NULL)
+    {
+        return mappedNodes[index];
+    }
+
+    const Page *page = &pages[lastPage];
+
+    if ((index < page->firstNode) || (index >= page->firstNode + page->nodeCount))
+    {
+        // Last page that starts at or before the node
+        auto next = std::upper_bound(pages.begin(), pages.end(), index, [](const UINT32 &node, const Page &page) { return node < page.firstNode; });
+        lastPage = (next - pages.begin()) - 1;
+        page = &pages[lastPage];
+    }
+
+    ResidentPage &residentPage = residentPages[lastPage];
+
+    if (residentPage.nodes.empty())
+    {
+        LoadPage(lastPage);
+    }
+
+    residentPage.lastUsed = useCounter;
+
+    return residentPage.nodes[index - page->firstNode];
+}
+
+void PointCloudEngine::OctreeCache::EvictPages()
+{
+    if (residentBytes > maxResidentBytes)
+    {
+        // Sort the pages that were not used since the last call from the least to the most recently used one
+        std::vector<std::pair<UINT64, size_t>> evictablePages;
+
+        for (size_t i = 0; i < residentPages.size(); i++)
+        {
+            if (!residentPages[i].nodes.empty() && (residentPages[i].lastUsed < useCounter))
+            {
+                evictablePages.push_back(std::pair<UINT64, size_t>(residentPages[i].lastUsed, i));
+            }
+        }
+
+        std::sort(evictablePages.begin(), evictablePages.end());
+
+        for (auto it = evictablePages.begin(); (it != evictablePages.end()) && (residentBytes > maxResidentBytes); it++)
+        {
+            std::vector<FlatOctreeNode> &nodes = residentPages[it->second].nodes;
+            residentBytes -= nodes.size() * sizeof(FlatOctreeNode);
+            residentPageCount--;
+
+            std::vector<FlatOctreeNode>().swap(nodes);
+        }
+    }
+
+    useCounter++;
+}
+
+size_t PointCloudEngine::OctreeCache::GetPageCount()
+{
+    return pages.size();
+}
+
+size_t PointCloudEngine::OctreeCache::GetResidentPageCount()
+{
+    return residentPageCount;
+}
+
+size_t PointCloudEngine::OctreeCache::GetResidentBytes()
+{
+    return residentBytes;
+}
+
+size_t PointCloudEngine::OctreeCache::GetPageLoadCount()
+{
+    return pageLoadCount;
+}
+
+bool PointCloudEngine::OctreeCache::Write(const std::wstring &plyfile, const int &depth, const UINT64 &vertexCount, const Vector3 &rootPosition, const float &rootSize, const FlatOctreeNode *nodes, const size_t &nodeCount, const std::vector<ClusteringStatistics> &clusteringStatistics)
+{
+    // Each page starts with a group of siblings and contains their descendants in breadth first order for the next levels
+    // The children of the nodes in the last level start new pages, this keeps the children of every node consecutive
+    std::vector<UINT32> order;
+    std::vector<UINT32> newIndices(nodeCount);
+    std::vector<Page> pages;
+    std::deque<std::pair<UINT32, UINT32>> pageSiblings;
+    std::vector<UINT32> level, nextLevel;
+
+    order.reserve(nodeCount);
+    pageSiblings.push_back(std::pair<UINT32, UINT32>(0, 1));
+
+    while (!pageSiblings.empty())
+    {
+        Page page;
+        page.firstNode = order.size();
+
+        level.clear();
+
+        for (UINT32 i = 0; i < pageSiblings.front().second; i++)
+        {
+            level.push_back(pageSiblings.front().first + i);
+        }
+
+        pageSiblings.pop_front();
+
+        for (int l = 0; (l < pageLevels) && !level.empty(); l++)
+        {
+            nextLevel.clear();
+
+            for (auto it = level.begin(); it != level.end(); it++)
+            {
+                const FlatOctreeNode &node = nodes[*it];
+                newIndices[*it] = order.size();
+                order.push_back(*it);
+
+                UINT32 childCount = 0;
+
+                for (int j = 0; j < 8; j++)
+                {
+                    if (node.childrenMask & (1 << j))
+                    {
+                        childCount++;
+                    }
+                }
+
+                if (childCount == 0)
+                {
+                    continue;
+                }
+
+                if (l + 1 < pageLevels)
+                {
+                    for (UINT32 j = 0; j < childCount; j++)
+                    {
+                        nextLevel.push_back(node.childrenStart + j);
+                    }
+                }
+                else
+                {
+                    pageSiblings.push_back(std::pair<UINT32, UINT32>(node.childrenStart, childCount));
+                }
+            }
+
+            level.swap(nextLevel);
+        }
+
+        page.nodeCount = order.size() - page.firstNode;
+        pages.push_back(page);
+    }
+
+    Header fileHeader;
+    ZeroMemory(&fileHeader, sizeof(Header));
+    memcpy(fileHeader.magic, OCTREECACHE_MAGIC, sizeof(fileHeader.magic));
+    fileHeader.version = version;
+    fileHeader.nodeSize = sizeof(FlatOctreeNode);
+    fileHeader.key = GetKey(plyfile, depth);
+    fileHeader.vertexCount = vertexCount;
+    fileHeader.nodeCount = nodeCount;
+    fileHeader.clusteringStatisticsCount = clusteringStatistics.size();
+    fileHeader.pageCount = pages.size();
+    fileHeader.rootPosition = rootPosition;
+    fileHeader.rootSize = rootSize;
+    fileHeader.checksum = GetChecksum(fileHeader);
+
+    std::wstring cacheFilename = GetCacheFilename(plyfile);
+    std::wstring temporaryFilename = cacheFilename + L".tmp";
+    std::ofstream cacheFile(temporaryFilename, std::ios::binary | std::ios::trunc);
+
+    cacheFile.write((const char*)&fileHeader, sizeof(Header));
+    cacheFile.write((const char*)clusteringStatistics.data(), clusteringStatistics.size() * sizeof(ClusteringStatistics));
+    cacheFile.write((const char*)pages.data(), pages.size() * sizeof(Page));
+
+    // Write the reordered nodes with their new children start indices in chunks
+    std::vector<FlatOctreeNode> chunk;
+    chunk.reserve(64 * 1024);
+
+    for (size_t i = 0; i < nodeCount; i++)
+    {
+        FlatOctreeNode node = nodes[order[i]];
+
+        if (node.childrenMask != 0)
+        {
+            node.childrenStart = newIndices[node.childrenStart];
+        }
+
+        chunk.push_back(node);
+
+        if ((chunk.size() == chunk.capacity()) || (i + 1 == nodeCount))
+        {
+            cacheFile.write((const char*)chunk.data(), chunk.size() * sizeof(FlatOctreeNode));
+            chunk.clear();
+        }
+    }
+
+    cacheFile.close();
+
+    if (cacheFile.fail())
+    {
+        DeleteFileW(temporaryFilename.c_str());
+        return false;
+    }
+
+    // Fails if the old cache is still opened by another octree, it is replaced the next time
+    if (!MoveFileExW(temporaryFilename.c_str(), cacheFilename.c_str(), MOVEFILE_REPLACE_EXISTING))
+    {
+        DeleteFileW(temporaryFilename.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+std::wstring PointCloudEngine::OctreeCache::GetCacheFilename(const std::wstring &plyfile)
+{
+    return plyfile + L".octree";
+}
+
+UINT64 PointCloudEngine::OctreeCache::GetKey(const std::wstring &plyfile, const int &depth)
+{
+    UINT64 key = 14695981039346656037ull;
+
+    WIN32_FILE_ATTRIBUTE_DATA attributes;
+
+    if (!GetFileAttributesExW(plyfile.c_str(), GetFileExInfoStandard, &attributes))
+    {
+        return 0;
+    }
+
+    Hash(key, &attributes.nFileSizeHigh, sizeof(DWORD));
+    Hash(key, &attributes.nFileSizeLow, sizeof(DWORD));
+    Hash(key, &attributes.ftLastWriteTime, sizeof(FILETIME));
+
+    // The header and the first and last vertices catch most changes that keep the size and time
+    const std::streamoff sampleSize = 64 * 1024;
+    std::streamoff fileSize = ((std::streamoff)attributes.nFileSizeHigh << 32) | attributes.nFileSizeLow;
+    std::ifstream ply(plyfile, std::ios::binary);
+    std::vector<char> sample(sampleSize);
+
+    ply.read(sample.data(), min(sampleSize, fileSize));
+    Hash(key, sample.data(), ply.gcount());
+
+    ply.clear();
+    ply.seekg(max((std::streamoff)0, fileSize - sampleSize));
+    ply.read(sample.data(), min(sampleSize, fileSize));
+    Hash(key, sample.data(), ply.gcount());
+
+    // All the settings that change the octree, the thread count is not included since the build is deterministic
+    int maxDepth = min(depth, MortonCode::maxDepth);
+    Hash(key, &maxDepth, sizeof(int));
+    Hash(key, &settings->octreeBuilder, sizeof(OctreeBuilder));
+    Hash(key, &settings->subdivisionMode, sizeof(SubdivisionMode));
+    Hash(key, &settings->maxLeafVertexCount, sizeof(int));
+    Hash(key, &settings->minNodeSize, sizeof(float));
+    Hash(key, &settings->clusteringMode, sizeof(ClusteringMode));
+    Hash(key, &settings->kMeansMaxIterations, sizeof(int));
+    Hash(key, &settings->kMeansTolerance, sizeof(float));
+    Hash(key, &settings->outOfCoreMemoryBudget, sizeof(int));
+    Hash(key, &settings->colorFormat, sizeof(ColorFormat));
+
+    return key;
+}
+
+UINT64 PointCloudEngine::OctreeCache::GetChecksum(const Header &header)
+{
+    UINT64 checksum = 14695981039346656037ull;
+    Hash(checksum, &header, offsetof(Header, checksum));
+
+    return checksum;
+}
+
+void PointCloudEngine::OctreeCache::Hash(UINT64 &hash, const void *data, const size_t &size)
+{
+    // FNV-1a
+    const byte *bytes = (const byte*)data;
+
+    for (size_t i = 0; i < size; i++)
+    {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+}
+
+bool PointCloudEngine::OctreeCache::Read(const UINT64 &offset, void *data, const size_t &size)
+{
+    // Read at the offset without moving the file pointer, large reads are split since ReadFile takes 32 bit sizes
+    size_t readBytes = 0;
+
+    while (readBytes < size)
+    {
+        OVERLAPPED overlapped;
+        ZeroMemory(&overlapped, sizeof(OVERLAPPED));
+        overlapped.Offset = (DWORD)(offset + readBytes);
+        overlapped.OffsetHigh = (DWORD)((offset + readBytes) >> 32);
+
+        DWORD chunkSize = (DWORD)min(size - readBytes, (size_t)(1 << 30));
+        DWORD chunkReadBytes = 0;
+
+        if (!ReadFile(file, (byte*)data + readBytes, chunkSize, &chunkReadBytes, &overlapped) || (chunkReadBytes != chunkSize))
+        {
+            return false;
+        }
+
+        readBytes += chunkSize;
+    }
+
+    return true;
+}
+
+UINT64 PointCloudEngine::OctreeCache::GetNodesOffset()
+{
+    return sizeof(Header) + header.clusteringStatisticsCount * sizeof(ClusteringStatistics) + header.pageCount * sizeof(Page);
+}
+
+void PointCloudEngine::OctreeCache::LoadPage(const size_t &pageIndex)
+{
+    const Page &page = pages[pageIndex];
+    std::vector<FlatOctreeNode> &nodes = residentPages[pageIndex].nodes;
+    nodes.resize(page.nodeCount);
+
+    // A page that cannot be read is kept as leaves without children to stop the traversal there
+    if (!Read(GetNodesOffset() + page.firstNode * sizeof(FlatOctreeNode), nodes.data(), nodes.size() * sizeof(FlatOctreeNode)))
+    {
+        ZeroMemory(nodes.data(), nodes.size() * sizeof(FlatOctreeNode));
+        ErrorMessage(L"Could not read a page of the octree cache.", L"LoadPage", __FILEW__, __LINE__);
+    }
+
+    residentPageCount++;
+    residentBytes += nodes.size() * sizeof(FlatOctreeNode);
+    pageLoadCount++;
+}
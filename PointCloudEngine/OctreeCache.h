@@ -0,0 +1,116 @@
+#ifndef OCTREECACHE_H
+#define OCTREECACHE_H
+
+#pragma once
+#include "PointCloudEngine.h"
+
+namespace PointCloudEngine
+{
+    // Binary file next to the ply file that stores the flat nodes of its octree
+    // A cache is only valid when its key matches the ply file and the build settings and its header checksum is correct
+    // The nodes are stored in pages, each page is a group of siblings and their descendants for a few levels
+    // Caches that fit into settings->octreePageBudget are memory mapped and the nodes are used in place without copying or parsing them
+    // Larger caches are streamed, pages are read when the traversal reaches them and the least recently used ones are evicted
+    class OctreeCache
+    {
+    public:
+        // Opens the cache file of the ply file, check IsValid before using the nodes
+        OctreeCache(const std::wstring &plyfile, const int &depth);
+        ~OctreeCache();
+
+        // False if there is no cache file or it is outdated, truncated or corrupt
+        bool IsValid();
+        bool IsStreamed();
+        size_t GetNodeCount();
+        std::vector<ClusteringStatistics> GetClusteringStatistics();
+
+        // Amount of vertices in the ply file the octree was built from
+        UINT64 GetVertexCount();
+
+        // The nodes only store their clusters, their cubes follow from the root cube
+        void GetRootPositionAndSize(Vector3 &outRootPosition, float &outSize);
+
+        // Streamed nodes stay valid until the next call of EvictPages, the cache is not thread safe
+        const FlatOctreeNode& GetNode(const UINT32 &index);
+
+        // Evicts the least recently used pages that were not used since the last call until the resident pages fit into the budget
+        void EvictPages();
+
+        // Statistics of the streamed pages, mapped caches have no resident pages
+        size_t GetPageCount();
+        size_t GetResidentPageCount();
+        size_t GetResidentBytes();
+        size_t GetPageLoadCount();
+
+        // Writes into a temporary file first and replaces the cache file afterwards, a cache is never left partially written
+        // The nodes are in breadth first order, they are reordered into pages while writing
+        static bool Write(const std::wstring &plyfile, const int &depth, const UINT64 &vertexCount, const Vector3 &rootPosition, const float &rootSize, const FlatOctreeNode *nodes, const size_t &nodeCount, const std::vector<ClusteringStatistics> &clusteringStatistics);
+        static std::wstring GetCacheFilename(const std::wstring &plyfile);
+
+    private:
+        // Increase when the layout of the file or the octree changes
+        static const UINT32 version = 4;
+
+        // Amount of levels below the siblings at the start of each page, a full page has 8 * (1 + 8 + 64 + 512) nodes
+        static const int pageLevels = 4;
+
+        struct Header
+        {
+            char magic[8];
+            UINT32 version;
+            UINT32 nodeSize;
+            UINT64 key;
+            UINT64 vertexCount;
+            UINT64 nodeCount;
+            UINT64 clusteringStatisticsCount;
+            UINT64 pageCount;
+            Vector3 rootPosition;
+            float rootSize;
+
+            // Hash of all the header values above
+            UINT64 checksum;
+        };
+
+        // Consecutive range of nodes, the pages are ordered by their first node
+        struct Page
+        {
+            UINT64 firstNode;
+            UINT64 nodeCount;
+        };
+
+        struct ResidentPage
+        {
+            std::vector<FlatOctreeNode> nodes;
+            UINT64 lastUsed = 0;
+        };
+
+        // Hash of the file size, the last write time, the first and last bytes of the ply file and all the build settings
+        // Hashing the whole ply file would take almost as long as loading it
+        static UINT64 GetKey(const std::wstring &plyfile, const int &depth);
+        static UINT64 GetChecksum(const Header &header);
+        static void Hash(UINT64 &hash, const void *data, const size_t &size);
+
+        bool Read(const UINT64 &offset, void *data, const size_t &size);
+        UINT64 GetNodesOffset();
+        void LoadPage(const size_t &pageIndex);
+
+        Header header;
+        bool valid = false;
+        std::vector<Page> pages;
+
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE mapping = NULL;
+        const byte *view = NULL;
+        const FlatOctreeNode *mappedNodes = NULL;
+
+        // Only used when the nodes are streamed, the last page is checked first since consecutive nodes are mostly in the same page
+        std::vector<ResidentPage> residentPages;
+        size_t residentPageCount = 0;
+        size_t residentBytes = 0;
+        size_t maxResidentBytes = 0;
+        size_t pageLoadCount = 0;
+        size_t lastPage = 0;
+        UINT64 useCounter = 1;
+    };
+}
+#endif
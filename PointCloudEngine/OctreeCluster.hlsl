@@ -32,12 +32,12 @@ void GS(point VS_INPUT input[1], inout LineStream<GS_OUTPUT> output)
 
     float3 end[] =
     {
-        input[0].position + extend * (weights[0] / maxWeight) * PolarNormalToFloat3(input[0].normal0),
-        input[0].position + extend * (weights[1] / maxWeight) * PolarNormalToFloat3(input[0].normal1),
-        input[0].position + extend * (weights[2] / maxWeight) * PolarNormalToFloat3(input[0].normal2),
-        input[0].position + extend * (weights[3] / maxWeight) * PolarNormalToFloat3(input[0].normal3),
-        input[0].position + extend * (weights[4] / maxWeight) * PolarNormalToFloat3(input[0].normal4),
-        input[0].position + extend * (weights[5] / maxWeight) * PolarNormalToFloat3(input[0].normal5)
+        input[0].position + extend * (weights[0] / maxWeight) * OctahedralNormalToFloat3(input[0].normal0),
+        input[0].position + extend * (weights[1] / maxWeight) * OctahedralNormalToFloat3(input[0].normal1),
+        input[0].position + extend * (weights[2] / maxWeight) * OctahedralNormalToFloat3(input[0].normal2),
+        input[0].position + extend * (weights[3] / maxWeight) * OctahedralNormalToFloat3(input[0].normal3),
+        input[0].position + extend * (weights[4] / maxWeight) * OctahedralNormalToFloat3(input[0].normal4),
+        input[0].position + extend * (weights[5] / maxWeight) * OctahedralNormalToFloat3(input[0].normal5)
     };
 
     GS_OUTPUT element;
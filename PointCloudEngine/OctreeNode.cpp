@@ -1,300 +1,443 @@
 #include "OctreeNode.h"
 
-PointCloudEngine::OctreeNode::OctreeNode(const std::vector<Vertex> &vertices, const Vector3 &center, const float &size, const int &depth)
+PointCloudEngine::OctreeNode::OctreeNode(PointBuffer *points, const size_t &first, const size_t &count, const Vector3 &center, const float &size, const int &depth, const UINT64 &id, MemoryArena *arena, TaskScheduler *scheduler, BuildProgress *progress)
 {
-    size_t vertexCount = vertices.size();
-    
-    if (vertexCount == 0)
+    if (count == 0)
     {
         ErrorMessage(L"Cannot create Octree Node from empty vertices!", L"CreateNode", __FILEW__, __LINE__);
         return;
     }
 
-    // The octree is generated by fitting the vertices into a cube at the center position
+    // The octree is generated by fitting the points into a cube at the center position
     // Then this cube is splitted into 8 smaller child cubes along the center
     // For each child cube the octree generation is repeated
     // Assign node values given by the parent
+    this->id = id;
     nodeVertex.size = size;
     nodeVertex.position = center;
 
-    // Apply the k-means clustering algorithm to find clusters for the normals
-    Vector3 means[6];
-    const int k = min(vertexCount, 6);
-    int verticesPerMean[6] = { 0, 0, 0, 0, 0, 0 };
+    // A cancelled build stops creating nodes, the incomplete octree is discarded by the caller
+    if ((progress != NULL) && progress->cancelled)
+    {
+        return;
+    }
+
+    bool subdivide = IsSubdivided(count, size, depth);
 
-    // Set initial means to the first k normals
-    for (int i = 0; i < k; i++)
+    // In the bottom up mode only the leaves cluster their points, inner nodes merge the clusters of their children
+    if (!subdivide || (settings->clusteringMode == ClusteringMode::PerNode))
     {
-        means[i] = vertices[i].normal;
-        verticesPerMean[i] = 1;
+        CalculateClusters(points, first, count);
     }
 
-    // Save the index of the mean that each vertex is assigned to
-    bool meanChanged = true;
-    byte *clusters = new byte[vertexCount];
-    ZeroMemory(clusters, sizeof(byte) * vertexCount);
+    if (!subdivide && (progress != NULL))
+    {
+        progress->processedVertexCount += count;
+    }
 
-    while (meanChanged)
+    if (subdivide)
     {
-        // Assign all the vertices to the closest mean to them
-        for (int i = 0; i < vertexCount; i++)
+        // Reorder the points so that the points of each child cube are the consecutive range [childStarts[i], childStarts[i + 1])
+        size_t childStarts[9];
+        PartitionVertices(points, first, count, childStarts);
+
+        TaskGroup childTasks;
+
+        for (int i = 0; i < 8; i++)
         {
-            float minDistance = Vector3::Distance(vertices[i].normal, means[clusters[i]]);
+            size_t childStart = childStarts[i];
+            size_t childVertexCount = childStarts[i + 1] - childStart;
 
-            for (int j = 0; j < k; j++)
+            if (childVertexCount > 0)
             {
-                float distance = Vector3::Distance(vertices[i].normal, means[j]);
-
-                if (distance < minDistance)
+                BuildChild(scheduler, childTasks, childVertexCount, [=]()
                 {
-                    clusters[i] = j;
-                    minDistance = distance;
-                }
+                    children[i] = arena->Create<OctreeNode>(GetThreadIndex(scheduler), points, childStart, childVertexCount, GetChildCenter(i), size / 2.0f, depth - 1, (id << 3) | i, arena, scheduler, progress);
+                });
             }
         }
 
-        // Calculate the new means from the vertices in each cluster
-        Vector3 newMeans[6];
-
-        for (int i = 0; i < k; i++)
+        if (scheduler != NULL)
         {
-            verticesPerMean[i] = 0;
+            scheduler->Wait(childTasks);
         }
 
-        for (int i = 0; i < vertexCount; i++)
+        if (settings->clusteringMode == ClusteringMode::BottomUp)
         {
-            newMeans[clusters[i]] += vertices[i].normal;
-            verticesPerMean[clusters[i]] += 1;
+            MergeChildClusters();
         }
+    }
+}
 
-        meanChanged = false;
-
-        // Update the means
-        for (int i = 0; i < k; i++)
-        {
-            if (verticesPerMean[i] > 0)
-            {
-                newMeans[i] /= verticesPerMean[i];
-
-                if (Vector3::DistanceSquared(means[i], newMeans[i]) > FLT_EPSILON)
-                {
-                    meanChanged = true;
-                }
+PointCloudEngine::OctreeNode::OctreeNode(const PointBuffer *points, const UINT64 *mortonCodes, const size_t &first, const size_t &count, const Vector3 &center, const float &size, const int &depth, const UINT64 &id, MemoryArena *arena, TaskScheduler *scheduler, BuildProgress *progress)
+{
+    if (count == 0)
+    {
+        ErrorMessage(L"Cannot create Octree Node from empty vertices!", L"CreateNode", __FILEW__, __LINE__);
+        return;
+    }
 
-                means[i] = newMeans[i];
-            }
-        }
+    this->id = id;
+    nodeVertex.size = size;
+    nodeVertex.position = center;
 
+    if ((progress != NULL) && progress->cancelled)
+    {
+        return;
     }
 
-    // Initialize average colors that are calculated per cluster
-    double averageReds[6] = { 0, 0, 0, 0, 0, 0 };
-    double averageGreens[6] = { 0, 0, 0, 0, 0, 0 };
-    double averageBlues[6] = { 0, 0, 0, 0, 0, 0 };
+    bool subdivide = IsSubdivided(count, size, depth);
 
-    // Calculate color
-    for (int i = 0; i < vertexCount; i++)
+    if (!subdivide || (settings->clusteringMode == ClusteringMode::PerNode))
     {
-        averageReds[clusters[i]] += vertices[i].color[0];
-        averageGreens[clusters[i]] += vertices[i].color[1];
-        averageBlues[clusters[i]] += vertices[i].color[2];
+        CalculateClusters(points, first, count);
     }
 
-    // Assign node vertex properties
-    for (int i = 0; i < 6; i++)
+    if (!subdivide && (progress != NULL))
     {
-        if (verticesPerMean[i] > 0)
-        {
-            averageReds[i] /= verticesPerMean[i];
-            averageGreens[i] /= verticesPerMean[i];
-            averageBlues[i] /= verticesPerMean[i];
-
-            nodeVertex.normals[i] = PolarNormal(means[i]);
-            nodeVertex.colors[i] = Color16(averageReds[i], averageGreens[i], averageBlues[i]);
-            nodeVertex.weights[i] = (255.0f * verticesPerMean[i]) / vertexCount;
-        }
-        else
-        {
-            nodeVertex.weights[i] = 0;
-        }
+        progress->processedVertexCount += count;
     }
 
-    delete[] clusters;
-
-    // Split and create children vertices
-    std::vector<Vertex> childVertices[8];
-
-    // Fit each vertex into its corresponding child cube
-    for (auto it = vertices.begin(); it != vertices.end(); it++)
+    if (subdivide)
     {
-        Vertex v = *it;
+        // All the morton codes in this node share the same prefix and are sorted
+        // Therefore the points of each child are a consecutive range where the 3 bits of this level are equal to the child index
+        int shift = 3 * (depth - 1);
+        size_t childStart = first;
+        TaskGroup childTasks;
 
-        if (v.position.x > center.x)
+        for (int i = 0; i < 8; i++)
         {
-            if (v.position.y > center.y)
-            {
-                if (v.position.z > center.z)
-                {
-                    childVertices[0].push_back(v);
-                }
-                else
-                {
-                    childVertices[1].push_back(v);
-                }
-            }
-            else
+            // Binary search for the end of the child range
+            size_t childEnd = std::partition_point(mortonCodes + childStart, mortonCodes + first + count, [=](const UINT64 &mortonCode) { return ((mortonCode >> shift) & 7) <= i; }) - mortonCodes;
+            size_t childVertexCount = childEnd - childStart;
+
+            if (childVertexCount > 0)
             {
-                if (v.position.z > center.z)
-                {
-                    childVertices[2].push_back(v);
-                }
-                else
+                BuildChild(scheduler, childTasks, childVertexCount, [=]()
                 {
-                    childVertices[3].push_back(v);
-                }
+                    children[i] = arena->Create<OctreeNode>(GetThreadIndex(scheduler), points, mortonCodes, childStart, childVertexCount, GetChildCenter(i), size / 2.0f, depth - 1, (id << 3) | i, arena, scheduler, progress);
+                });
             }
+
+            childStart = childEnd;
         }
-        else
+
+        if (scheduler != NULL)
         {
-            if (v.position.y > center.y)
-            {
-                if (v.position.z > center.z)
-                {
-                    childVertices[4].push_back(v);
-                }
-                else
-                {
-                    childVertices[5].push_back(v);
-                }
-            }
-            else
-            {
-                if (v.position.z > center.z)
-                {
-                    childVertices[6].push_back(v);
-                }
-                else
-                {
-                    childVertices[7].push_back(v);
-                }
-            }
+            scheduler->Wait(childTasks);
+        }
+
+        if (settings->clusteringMode == ClusteringMode::BottomUp)
+        {
+            MergeChildClusters();
         }
     }
+}
 
-    // Assign the centers for each child cube
-    float childExtend = 0.25f * nodeVertex.size;
+PointCloudEngine::OctreeNode::OctreeNode(const Vector3 &center, const float &size, const UINT64 &id, OctreeNode *children[8])
+{
+    this->id = id;
+    nodeVertex.size = size;
+    nodeVertex.position = center;
 
-    // Correlates to the assigned child vertices
-    Vector3 childCenters[8] =
+    for (int i = 0; i < 8; i++)
     {
-        center + Vector3(childExtend, childExtend, childExtend),
-        center + Vector3(childExtend, childExtend, -childExtend),
-        center + Vector3(childExtend, -childExtend, childExtend),
-        center + Vector3(childExtend, -childExtend, -childExtend),
-        center + Vector3(-childExtend, childExtend, childExtend),
-        center + Vector3(-childExtend, childExtend, -childExtend),
-        center + Vector3(-childExtend, -childExtend, childExtend),
-        center + Vector3(-childExtend, -childExtend, -childExtend)
-    };
-
-    // Only subdivide further if the size is above the minimum size
-    if (depth > 0)
+        this->children[i] = children[i];
+    }
+
+    MergeChildClusters();
+}
+
+void PointCloudEngine::OctreeNode::CalculateClusters(const PointBuffer *points, const size_t &first, const size_t &count)
+{
+    clusteringIterations = CalculateClusterSummaries(points->GetNormals() + first, points->GetColors() + 3 * first, count, clusterSummaries);
+    AssignClusters(clusterSummaries, nodeVertex);
+}
+
+void PointCloudEngine::OctreeNode::MergeChildClusters()
+{
+    ClusterSummary childSummaries[48];
+    int childClusterCount = 0;
+
+    for (int i = 0; i < 8; i++)
     {
-        for (int i = 0; i < 8; i++)
+        if (children[i] != NULL)
         {
-            if (childVertices[i].size() > 0)
+            for (int j = 0; j < 6; j++)
             {
-                children[i] = new OctreeNode(childVertices[i], childCenters[i], size / 2.0f, depth - 1);
+                childSummaries[childClusterCount++] = children[i]->clusterSummaries[j];
             }
         }
     }
+
+    clusteringIterations = MergeClusterSummaries(childSummaries, childClusterCount, clusterSummaries);
+    AssignClusters(clusterSummaries, nodeVertex);
 }
 
-PointCloudEngine::OctreeNode::~OctreeNode()
+int PointCloudEngine::OctreeNode::CalculateClusterSummaries(const Vector3 *normals, const byte *colors, const size_t &count, ClusterSummary outClusterSummaries[6])
 {
-    // Delete children
-    for (int i = 0; i < 8; i++)
+    // Apply the k-means clustering algorithm to find clusters for the normals
+    Vector3 means[6];
+    int verticesPerMean[6];
+
+    // Save the index of the mean that each point is assigned to
+    MemoryArena &scratchArena = MemoryArena::GetScratchArena();
+    MemoryArena::Marker marker = scratchArena.GetMarker();
+    byte *clusters = scratchArena.AllocateArray<byte>(count);
+    int iterations = KMeans::ClusterNormals(normals, count, means, verticesPerMean, clusters);
+
+    for (int i = 0; i < 6; i++)
     {
-        SafeDelete(children[i]);
+        outClusterSummaries[i] = ClusterSummary();
+        outClusterSummaries[i].mean = means[i];
+        outClusterSummaries[i].count = verticesPerMean[i];
     }
+
+    // Sum up the colors of each cluster
+    for (size_t i = 0; i < count; i++)
+    {
+        ClusterSummary &clusterSummary = outClusterSummaries[clusters[i]];
+        clusterSummary.colorSums[0] += colors[3 * i];
+        clusterSummary.colorSums[1] += colors[3 * i + 1];
+        clusterSummary.colorSums[2] += colors[3 * i + 2];
+    }
+
+    scratchArena.Rewind(marker);
+
+    return iterations;
 }
 
-std::vector<OctreeNodeVertex> PointCloudEngine::OctreeNode::GetVertices(const Vector3 &localCameraPosition, const float &splatSize)
+int PointCloudEngine::OctreeNode::CalculateClusterSummaries(const Vertex *vertices, const size_t &vertexCount, ClusterSummary outClusterSummaries[6])
 {
-    // TODO: View frustum culling by checking the node bounding box against all the view frustum planes (don't check again if fully inside)
-    // TODO: Visibility culling by comparing the maximum angle (normal cone) from the mean to all normals in the cluster against the view direction
-    // Only return a vertex if its projected size is smaller than the passed size or it is a leaf node
-    std::vector<OctreeNodeVertex> octreeVertices;
-    float distanceToCamera = Vector3::Distance(localCameraPosition, nodeVertex.position);
-
-    // Scale the local space splat size by the fov and camera distance (Result: size at that distance in local space)
-    float requiredSplatSize = splatSize * (2.0f * tan(settings->fovAngleY / 2.0f)) * distanceToCamera;
+    MemoryArena &scratchArena = MemoryArena::GetScratchArena();
+    MemoryArena::Marker marker = scratchArena.GetMarker();
+    Vector3 *normals = scratchArena.AllocateArray<Vector3>(vertexCount);
+    byte *colors = scratchArena.AllocateArray<byte>(3 * vertexCount);
 
-    if ((nodeVertex.size < requiredSplatSize) || IsLeafNode())
+    for (size_t i = 0; i < vertexCount; i++)
     {
-        // Make sure that e.g. single point nodes with size 0 are drawn as well
-        if (nodeVertex.size < FLT_EPSILON)
-        {
-            // Set the size temporarily to the splat size in local space to make sure that this node is visible
-            OctreeNodeVertex tmp = nodeVertex;
-            tmp.size = requiredSplatSize;
+        normals[i] = vertices[i].normal;
+        std::copy(vertices[i].color, vertices[i].color + 3, colors + 3 * i);
+    }
 
-            octreeVertices.push_back(tmp);
-        }
-        else
+    int iterations = CalculateClusterSummaries(normals, colors, vertexCount, outClusterSummaries);
+    scratchArena.Rewind(marker);
+
+    return iterations;
+}
+
+int PointCloudEngine::OctreeNode::MergeClusterSummaries(const ClusterSummary *clusterSummaries, const int &count, ClusterSummary outClusterSummaries[6])
+{
+    // The non empty clusters are weighted by their vertex count and clustered again into 6 clusters
+    Vector3 means[48];
+    UINT64 counts[48];
+    const ClusterSummary *summaries[48];
+    int clusterCount = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        if (clusterSummaries[i].count > 0)
         {
-            octreeVertices.push_back(nodeVertex);
+            summaries[clusterCount] = &clusterSummaries[i];
+            means[clusterCount] = clusterSummaries[i].mean;
+            counts[clusterCount] = clusterSummaries[i].count;
+            clusterCount++;
         }
     }
-    else
+
+    Vector3 mergedMeans[6];
+    byte clusters[48];
+    int iterations = KMeans::ClusterWeightedNormals(means, counts, clusterCount, mergedMeans, clusters);
+
+    // Merge the summaries of the clusters, the mean of the merged cluster is exactly the mean of all its vertex normals
+    Vector3 normalSums[6];
+
+    for (int i = 0; i < 6; i++)
     {
-        // Traverse the whole octree and add child vertices
-        for (int i = 0; i < 8; i++)
+        outClusterSummaries[i] = ClusterSummary();
+    }
+
+    for (int i = 0; i < clusterCount; i++)
+    {
+        ClusterSummary &clusterSummary = outClusterSummaries[clusters[i]];
+        normalSums[clusters[i]] += (float)counts[i] * means[i];
+        clusterSummary.count += counts[i];
+        clusterSummary.colorSums[0] += summaries[i]->colorSums[0];
+        clusterSummary.colorSums[1] += summaries[i]->colorSums[1];
+        clusterSummary.colorSums[2] += summaries[i]->colorSums[2];
+    }
+
+    for (int i = 0; i < 6; i++)
+    {
+        if (outClusterSummaries[i].count > 0)
         {
-            if (children[i] != NULL)
-            {
-                std::vector<OctreeNodeVertex> childOctreeVertices = children[i]->GetVertices(localCameraPosition, splatSize);
-                octreeVertices.insert(octreeVertices.end(), childOctreeVertices.begin(), childOctreeVertices.end());
-            }
+            outClusterSummaries[i].mean = normalSums[i] / (float)outClusterSummaries[i].count;
         }
     }
 
-    return octreeVertices;
+    return iterations;
 }
 
-std::vector<OctreeNodeVertex> PointCloudEngine::OctreeNode::GetVerticesAtLevel(const int &level)
+void PointCloudEngine::OctreeNode::AssignClusters(const ClusterSummary clusterSummaries[6], OctreeNodeVertex &outNodeVertex)
 {
-    std::vector<OctreeNodeVertex> octreeVertices;
+    UINT64 vertexCount = 0;
 
-    if (level == 0)
+    for (int i = 0; i < 6; i++)
     {
-        octreeVertices.push_back(nodeVertex);
+        vertexCount += clusterSummaries[i].count;
     }
-    else if (level > 0)
+
+    // Round the cumulative vertex counts instead of each weight, this way the weights always sum up to exactly 255
+    // Only 5 weights are stored in the flat nodes and the last one is calculated from the others
+    UINT64 cumulativeCount = 0;
+    UINT64 cumulativeWeight = 0;
+
+    // Empty clusters keep the empty normal (0, 0, 0) and black
+    Vector3 means[6];
+    byte colors[18];
+
+    // Assign node vertex properties
+    for (int i = 0; i < 6; i++)
     {
-        // Traverse the whole octree and add child vertices
-        for (int i = 0; i < 8; i++)
+        const ClusterSummary &clusterSummary = clusterSummaries[i];
+
+        if (clusterSummary.count > 0)
         {
-            if (children[i] != NULL)
+            means[i] = clusterSummary.mean;
+
+            for (int j = 0; j < 3; j++)
             {
-                std::vector<OctreeNodeVertex> childOctreeVertices = children[i]->GetVerticesAtLevel(level - 1);
-                octreeVertices.insert(octreeVertices.end(), childOctreeVertices.begin(), childOctreeVertices.end());
+                colors[3 * i + j] = (byte)(clusterSummary.colorSums[j] / clusterSummary.count + 0.5);
             }
+
+            cumulativeCount += clusterSummary.count;
+            UINT64 weight = (255 * cumulativeCount + vertexCount / 2) / vertexCount;
+            outNodeVertex.weights[i] = weight - cumulativeWeight;
+            cumulativeWeight = weight;
+        }
+        else
+        {
+            means[i] = Vector3::Zero;
+            std::fill(colors + 3 * i, colors + 3 * i + 3, 0);
+            outNodeVertex.weights[i] = 0;
         }
     }
 
-    return octreeVertices;
+    NormalCodec::Encode(means, 6, outNodeVertex.normals);
+    ColorCodec::Encode(colors, 6, outNodeVertex.colors, settings->colorFormat);
+}
+
+Vector3 PointCloudEngine::OctreeNode::GetChildCenter(const Vector3 &center, const float &size, const int &childIndex)
+{
+    // Child index bits are (x, y, z) where 0 is the positive and 1 the negative half along this axis
+    float childExtend = 0.25f * size;
+
+    float x = (childIndex & 4) ? -childExtend : childExtend;
+    float y = (childIndex & 2) ? -childExtend : childExtend;
+    float z = (childIndex & 1) ? -childExtend : childExtend;
+
+    return center + Vector3(x, y, z);
 }
 
-bool PointCloudEngine::OctreeNode::IsLeafNode()
+int PointCloudEngine::OctreeNode::GetChildIndex(const Vector3 &center, const Vector3 &position)
 {
+    // Same order as the child centers, vertices exactly on the center belong to the negative half
+    int x = (position.x > center.x) ? 0 : 4;
+    int y = (position.y > center.y) ? 0 : 2;
+    int z = (position.z > center.z) ? 0 : 1;
+
+    return x | y | z;
+}
+
+Vector3 PointCloudEngine::OctreeNode::GetChildCenter(const int &childIndex)
+{
+    return GetChildCenter(nodeVertex.position, nodeVertex.size, childIndex);
+}
+
+int PointCloudEngine::OctreeNode::GetChildIndex(const Vector3 &position)
+{
+    return GetChildIndex(nodeVertex.position, position);
+}
+
+void PointCloudEngine::OctreeNode::PartitionVertices(PointBuffer *points, const size_t &first, const size_t &count, size_t childStarts[9])
+{
+    Vector3 *positions = points->GetPositions();
+    Vector3 *normals = points->GetNormals();
+    byte *colors = points->GetColors();
+
+    // Count the points of each child first to know where each child range starts, this only reads the positions
+    size_t childCounts[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+
+    for (size_t i = first; i < first + count; i++)
+    {
+        childCounts[GetChildIndex(positions[i])]++;
+    }
+
+    childStarts[0] = first;
+
     for (int i = 0; i < 8; i++)
     {
-        if (children[i] != NULL)
+        childStarts[i + 1] = childStarts[i] + childCounts[i];
+    }
+
+    // Scatter in place by swapping every point into the next free slot of its child range (american flag sort)
+    // Each swap moves at least one point to its final place, therefore this takes at most count swaps of all 3 arrays
+    size_t nextFree[8];
+    std::copy(childStarts, childStarts + 8, nextFree);
+
+    for (int i = 0; i < 8; i++)
+    {
+        while (nextFree[i] < childStarts[i + 1])
         {
-            return false;
+            size_t index = nextFree[i];
+            int childIndex = GetChildIndex(positions[index]);
+
+            if (childIndex == i)
+            {
+                nextFree[i]++;
+            }
+            else
+            {
+                size_t other = nextFree[childIndex]++;
+                std::swap(positions[index], positions[other]);
+                std::swap(normals[index], normals[other]);
+                std::swap_ranges(colors + 3 * index, colors + 3 * index + 3, colors + 3 * other);
+            }
         }
     }
+}
+
+bool PointCloudEngine::OctreeNode::IsSubdivided(const size_t &vertexCount, const float &size, const int &depth)
+{
+    // The depth is always the upper limit, in the adaptive mode it is only a safety cap for e.g. many points at the same position
+    if (depth <= 0)
+    {
+        return false;
+    }
+
+    if (settings->subdivisionMode == SubdivisionMode::Adaptive)
+    {
+        return (vertexCount > (size_t)settings->maxLeafVertexCount) && (size > settings->minNodeSize);
+    }
 
     return true;
 }
+
+int PointCloudEngine::OctreeNode::GetThreadIndex(TaskScheduler *scheduler)
+{
+    return (scheduler != NULL) ? scheduler->GetWorkerIndex() : 0;
+}
+
+void PointCloudEngine::OctreeNode::BuildChild(TaskScheduler *scheduler, TaskGroup &childTasks, const size_t &childVertexCount, std::function<void()> build)
+{
+    // Large child subtrees are built in parallel by the scheduler, small ones sequentially since a task would cost more than it gains
+    if ((scheduler != NULL) && (childVertexCount >= settings->parallelBuildCutoff))
+    {
+        scheduler->Spawn(childTasks, build);
+    }
+    else
+    {
+        build();
+    }
+}
\ No newline at end of file
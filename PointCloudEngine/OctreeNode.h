@@ -9,15 +9,61 @@ namespace PointCloudEngine
     class OctreeNode
     {
     public:
-        OctreeNode (const std::vector<Vertex> &vertices, const Vector3 &center, const float &size, const int &depth);
-        ~OctreeNode();
+        // The children are created in the arena with the worker index of the scheduler, the whole tree is freed at once with the arena
+        // Therefore the nodes have no destructor and have to be created in an arena as well
 
-        std::vector<OctreeNodeVertex> GetVertices(const Vector3 &localCameraPosition, const float &splatSize);
-        std::vector<OctreeNodeVertex> GetVerticesAtLevel(const int &level);
-        bool IsLeafNode();
+        // The builders work on the range [first, first + count) of the points, the position, normal and color arrays are read separately
+
+        // Top down builder, partitions the range in place into the 8 child cubes and passes each child its range
+        OctreeNode (PointBuffer *points, const size_t &first, const size_t &count, const Vector3 &center, const float &size, const int &depth, const UINT64 &id, MemoryArena *arena, TaskScheduler *scheduler = NULL, BuildProgress *progress = NULL);
+
+        // Morton builder, the points and their codes are sorted by the morton codes and each child is a consecutive range of them
+        OctreeNode (const PointBuffer *points, const UINT64 *mortonCodes, const size_t &first, const size_t &count, const Vector3 &center, const float &size, const int &depth, const UINT64 &id, MemoryArena *arena, TaskScheduler *scheduler = NULL, BuildProgress *progress = NULL);
+
+        // Inner node from already built children, the clusters are merged bottom up from the children (used by the out-of-core builder)
+        OctreeNode (const Vector3 &center, const float &size, const UINT64 &id, OctreeNode *children[8]);
 
         OctreeNode *children[8] = { NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL };
         OctreeNodeVertex nodeVertex;
+
+        // Leading 1 bit followed by the 3 bit child index of each level, this is the morton code prefix of the node cube
+        // Stays the same when the octree is rebuilt, both builders only agree on it away from the cell boundaries
+        // The morton codes quantize the positions, a vertex exactly on a boundary can end up in the other child than GetChildIndex gives
+        UINT64 id = 1;
+
+        // Iterations that the normal clustering of this node took, only used for the build statistics
+        int clusteringIterations = 0;
+
+        // Full precision clusters of the node, the bottom up clustering merges them into the clusters of the parent
+        ClusterSummary clusterSummaries[6];
+
+        // Child cube of a cube with this center and size, the child index bits are (x, y, z)
+        static Vector3 GetChildCenter(const Vector3 &center, const float &size, const int &childIndex);
+        static int GetChildIndex(const Vector3 &center, const Vector3 &position);
+
+        // Returns true if a node with these properties has children, depends on the subdivision mode
+        static bool IsSubdivided(const size_t &vertexCount, const float &size, const int &depth);
+
+        // Clusters the normals with k-means and sums up the colors (3 bytes per point) of each cluster, returns the k-means iterations
+        static int CalculateClusterSummaries(const Vector3 *normals, const byte *colors, const size_t &count, ClusterSummary outClusterSummaries[6]);
+
+        // Same for the vertex format of the dynamic leaves, the normals and colors are copied into arrays first
+        static int CalculateClusterSummaries(const Vertex *vertices, const size_t &vertexCount, ClusterSummary outClusterSummaries[6]);
+
+        // Merges at most 48 clusters (of the 8 children) into 6 clusters, empty clusters are ignored, returns the k-means iterations
+        static int MergeClusterSummaries(const ClusterSummary *clusterSummaries, const int &count, ClusterSummary outClusterSummaries[6]);
+
+        // Sets the normals, colors and weights of the node vertex from its clusters
+        static void AssignClusters(const ClusterSummary clusterSummaries[6], OctreeNodeVertex &outNodeVertex);
+
+    private:
+        void CalculateClusters(const PointBuffer *points, const size_t &first, const size_t &count);
+        void MergeChildClusters();
+        Vector3 GetChildCenter(const int &childIndex);
+        int GetChildIndex(const Vector3 &position);
+        void PartitionVertices(PointBuffer *points, const size_t &first, const size_t &count, size_t childStarts[9]);
+        static int GetThreadIndex(TaskScheduler *scheduler);
+        void BuildChild(TaskScheduler *scheduler, TaskGroup &childTasks, const size_t &childVertexCount, std::function<void()> build);
     };
 }
 
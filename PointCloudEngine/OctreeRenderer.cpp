@@ -1,24 +1,41 @@
 #include "OctreeRenderer.h"
 
-OctreeRenderer::OctreeRenderer(const std::vector<Vertex> &vertices)
+OctreeRenderer::OctreeRenderer(PointBuffer points, BuildProgress *progress)
 {
     // Create the octree
-    octree = new Octree(vertices, settings->maxOctreeDepth);
+    octree = new Octree(std::move(points), settings->maxOctreeDepth, progress);
+    SetDefaultValues();
+}
 
-    // Text for showing properties
-    text = Hierarchy::Create(L"OctreeRendererText");
-    textRenderer = text->AddComponent(new TextRenderer(TextRenderer::GetSpriteFont(L"Consolas"), false));
+OctreeRenderer::OctreeRenderer(const std::wstring &plyfile, BuildProgress *progress)
+{
+    octree = new Octree(plyfile, settings->maxOctreeDepth, progress);
+    SetDefaultValues();
+}
 
-    text->transform->position = Vector3(-1, -0.90, 0);
-    text->transform->scale = 0.35f * Vector3::One;
+OctreeRenderer::OctreeRenderer(OctreeCache *cache)
+{
+    octree = new Octree(cache);
+    SetDefaultValues();
+}
 
+void OctreeRenderer::SetDefaultValues()
+{
     // Initialize constant buffer data
     constantBufferData.fovAngleY = settings->fovAngleY;
     constantBufferData.splatSize = 0.01f;
+    constantBufferData.colorFormat = (int)octree->GetColorFormat();
 }
 
 void OctreeRenderer::Initialize(SceneObject *sceneObject)
 {
+    // Text for showing properties, the hierarchy can only be changed on the main thread
+    text = Hierarchy::Create(L"OctreeRendererText");
+    textRenderer = text->AddComponent(new TextRenderer(TextRenderer::GetSpriteFont(L"Consolas"), false));
+
+    text->transform->position = Vector3(-1, -0.90, 0);
+    text->transform->scale = 0.35f * Vector3::One;
+
     // Create the constant buffer for WVP
     D3D11_BUFFER_DESC cbDescWVP;
     ZeroMemory(&cbDescWVP, sizeof(cbDescWVP));
@@ -50,18 +67,21 @@ void OctreeRenderer::Update(SceneObject *sceneObject)
         viewMode = (viewMode + 1) % 3;
     }
 
-    // Create new buffer from the current octree traversal
+    // Fill the vertices with the current octree traversal, the vector keeps its capacity from the previous frames
     if (level < 0)
     {
         Matrix worldInverse = sceneObject->transform->worldMatrix.Invert();
         Vector3 cameraPosition = camera->GetPosition();
         Vector3 localCameraPosition = Vector4::Transform(Vector4(cameraPosition.x, cameraPosition.y, cameraPosition.z, 1), worldInverse);
 
-        octreeVertices = octree->GetVertices(localCameraPosition, constantBufferData.splatSize);
+        // With the world matrix the frustum planes are in the local space of the octree like the camera position
+        ViewFrustum frustum(sceneObject->transform->worldMatrix * camera->GetViewMatrix() * camera->GetProjectionMatrix());
+
+        octree->GetVertices(localCameraPosition, frustum, constantBufferData.splatSize, octreeVertices);
     }
     else
     {
-        octreeVertices = octree->GetVerticesAtLevel(level);
+        octree->GetVerticesAtLevel(level, octreeVertices);
     }
 
     // Set the text
@@ -182,7 +202,12 @@ void OctreeRenderer::Release()
 {
     SafeDelete(octree);
 
-    Hierarchy::ReleaseSceneObject(text);
+    // The text only exists if the renderer was initialized
+    if (text != NULL)
+    {
+        Hierarchy::ReleaseSceneObject(text);
+        text = NULL;
+    }
 
     SafeRelease(vertexBuffer);
     SafeRelease(constantBuffer);
@@ -197,3 +222,8 @@ void PointCloudEngine::OctreeRenderer::GetBoundingCubePositionAndSize(Vector3 &o
 {
     octree->GetRootPositionAndSize(outPosition, outSize);
 }
+
+bool PointCloudEngine::OctreeRenderer::WriteCache(const std::wstring &plyfile, const UINT64 &vertexCount)
+{
+    return octree->WriteCache(plyfile, settings->maxOctreeDepth, vertexCount);
+}
@@ -9,7 +9,15 @@ namespace PointCloudEngine
     class OctreeRenderer : public Component, public IRenderer
     {
     public:
-        OctreeRenderer(const std::vector<Vertex> &vertices);
+        // The constructors only build the octree and can run on a background thread, the resources are created in Initialize
+        // The octree reorders the points in place while building, move them in to avoid copying them
+        OctreeRenderer(PointBuffer points, BuildProgress *progress = NULL);
+
+        // Builds the octree out-of-core directly from the ply file
+        OctreeRenderer(const std::wstring &plyfile, BuildProgress *progress = NULL);
+
+        // Uses the octree of a valid cache without building it, the renderer owns the cache afterwards
+        OctreeRenderer(OctreeCache *cache);
         void Initialize(SceneObject *sceneObject);
         void Update(SceneObject *sceneObject);
         void Draw(SceneObject *sceneObject);
@@ -18,7 +26,12 @@ namespace PointCloudEngine
         void SetSplatSize(const float& splatSize);
         void GetBoundingCubePositionAndSize(Vector3 &outPosition, float &outSize);
 
+        // Saves the built octree next to the ply file to skip loading and building it the next time
+        bool WriteCache(const std::wstring &plyfile, const UINT64 &vertexCount);
+
     private:
+        void SetDefaultValues();
+
         // Same constant buffer as in effect file, keep packing rules in mind
         struct OctreeRendererConstantBuffer
         {
@@ -29,7 +42,8 @@ namespace PointCloudEngine
             Vector3 cameraPosition;
             float fovAngleY;
             float splatSize;
-            float padding[3];
+            int colorFormat;
+            float padding[2];
         };
 
         int level = -1;
@@ -44,8 +58,8 @@ namespace PointCloudEngine
 
         // Vertex buffer
         UINT vertexBufferSize = 0;
-        ID3D11Buffer* vertexBuffer;		        // Holds vertex data
-        ID3D11Buffer* constantBuffer;		    // Stores data and sends it to the actual buffer in the effect file
+        ID3D11Buffer* vertexBuffer = NULL;		// Holds vertex data
+        ID3D11Buffer* constantBuffer = NULL;	// Stores data and sends it to the actual buffer in the effect file
     };
 }
 #endif
@@ -19,12 +19,12 @@ VS_OUTPUT VS(VS_INPUT input)
 {
     float3 normals[6] =
     {
-        PolarNormalToFloat3(input.normal0),
-        PolarNormalToFloat3(input.normal1),
-        PolarNormalToFloat3(input.normal2),
-        PolarNormalToFloat3(input.normal3),
-        PolarNormalToFloat3(input.normal4),
-        PolarNormalToFloat3(input.normal5)
+        OctahedralNormalToFloat3(input.normal0),
+        OctahedralNormalToFloat3(input.normal1),
+        OctahedralNormalToFloat3(input.normal2),
+        OctahedralNormalToFloat3(input.normal3),
+        OctahedralNormalToFloat3(input.normal4),
+        OctahedralNormalToFloat3(input.normal5)
     };
     
     float3 colors[6] =
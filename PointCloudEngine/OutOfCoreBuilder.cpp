@@ -0,0 +1,457 @@
+#include "OutOfCoreBuilder.h"
+
+#define TEMPORARY_DIRECTORY_PREFIX L"PointCloudEngineOutOfCore_"
+
+PointCloudEngine::OutOfCoreBuilder::OutOfCoreBuilder(const std::wstring &plyfile, BuildProgress *progress)
+{
+    this->plyfile = plyfile;
+    this->progress = progress;
+}
+
+PointCloudEngine::OutOfCoreBuilder::~OutOfCoreBuilder()
+{
+    SafeDelete(scheduler);
+}
+
+bool PointCloudEngine::OutOfCoreBuilder::Build(const int &depth, std::vector<FlatOctreeNode> &outNodes, std::vector<ClusteringStatistics> &outClusteringStatistics, Vector3 &outRootPosition, float &outRootSize)
+{
+    PlyStream header(plyfile);
+
+    if (!header.IsValid())
+    {
+        return false;
+    }
+
+    vertexCount = header.GetVertexCount();
+
+    // Half of the budget is left for the linked nodes of a cube that is built in memory
+    // The two staging buffers of the ply stream, the converted chunk and the sorted chunk use at most another quarter of it
+    size_t memoryBudget = (size_t)max(1, settings->outOfCoreMemoryBudget) * 1024 * 1024;
+    maxCubeVertexCount = max((size_t)1, memoryBudget / (2 * sizeof(Vertex)));
+    chunkSize = max((size_t)1, memoryBudget / (4 * (2 * sizeof(Vertex) + 2 * header.GetVertexStride())));
+
+    // Calculate center and size of the root node with a first pass over the file
+    Vector3 minPosition(FLT_MAX, FLT_MAX, FLT_MAX);
+    Vector3 maxPosition(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+    bool boundsRead = ReadChunks(plyfile, [&](const Vertex *vertices, const size_t &count)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            minPosition = Vector3::Min(minPosition, vertices[i].position);
+            maxPosition = Vector3::Max(maxPosition, vertices[i].position);
+        }
+    });
+
+    if (!boundsRead)
+    {
+        return false;
+    }
+
+    Vector3 diagonal = maxPosition - minPosition;
+    Vector3 center = minPosition + 0.5f * (diagonal);
+    float size = max(max(diagonal.x, diagonal.y), diagonal.z);
+
+    outRootPosition = center;
+    outRootSize = size;
+
+    // Only the vertices of the cubes that are built in memory count as processed
+    if (progress != NULL)
+    {
+        progress->vertexCount = vertexCount;
+    }
+
+    temporaryDirectory = CreateTemporaryDirectory();
+
+    if (temporaryDirectory.empty())
+    {
+        return false;
+    }
+
+    scheduler = new TaskScheduler(settings->buildThreadCount);
+
+    OctreeNode *root = BuildCube(plyfile, vertexCount, center, size, depth, 1, 0);
+
+    SafeDelete(scheduler);
+    RemoveDirectoryW(temporaryDirectory.c_str());
+
+    if (failed || (root == NULL))
+    {
+        nodeArena.Release();
+        cubes.clear();
+
+        return false;
+    }
+
+    // Breadth first order over the linked coarse nodes and the flat nodes of the cubes
+    // The children of a node are appended at once, therefore they are consecutive and ordered by their child index
+    std::vector<NodeReference> nodeOrder;
+    nodeOrder.push_back(GetNodeReference(root, 0));
+
+    for (size_t i = 0; i < nodeOrder.size(); i++)
+    {
+        NodeReference reference = nodeOrder[i];
+        FlatOctreeNode flatNode;
+
+        if (reference.node != NULL)
+        {
+            flatNode.SetClusters(reference.node->nodeVertex);
+            flatNode.childrenStart = nodeOrder.size();
+            flatNode.childrenMask = 0;
+
+            for (int j = 0; j < 8; j++)
+            {
+                if (reference.node->children[j] != NULL)
+                {
+                    flatNode.childrenMask |= 1 << j;
+                    nodeOrder.push_back(GetNodeReference(reference.node->children[j], reference.level + 1));
+                }
+            }
+
+            // The statistics of the cubes are already collected when flattening them
+            if (reference.level >= clusteringStatistics.size())
+            {
+                clusteringStatistics.resize(reference.level + 1);
+            }
+
+            ClusteringStatistics &statistics = clusteringStatistics[reference.level];
+            statistics.nodeCount++;
+            statistics.iterations += reference.node->clusteringIterations;
+            statistics.maxIterations = max(statistics.maxIterations, reference.node->clusteringIterations);
+
+            if (reference.node->clusteringIterations >= settings->kMeansMaxIterations)
+            {
+                statistics.cappedNodeCount++;
+            }
+        }
+        else
+        {
+            // Translate the child index of the cube nodes to the index in the output
+            flatNode = (*reference.cubeNodes)[reference.index];
+            UINT32 cubeChildIndex = flatNode.childrenStart;
+            flatNode.childrenStart = nodeOrder.size();
+
+            for (int j = 0; j < 8; j++)
+            {
+                if (flatNode.childrenMask & (1 << j))
+                {
+                    NodeReference childReference = { NULL, reference.cubeNodes, cubeChildIndex++, reference.level + 1 };
+                    nodeOrder.push_back(childReference);
+                }
+            }
+        }
+
+        outNodes.push_back(flatNode);
+    }
+
+    outNodes.shrink_to_fit();
+    outClusteringStatistics = clusteringStatistics;
+
+    nodeArena.Release();
+    cubes.clear();
+
+    return true;
+}
+
+size_t PointCloudEngine::OutOfCoreBuilder::GetVertexCount(const std::wstring &plyfile)
+{
+    PlyStream stream(plyfile);
+
+    if (stream.IsValid())
+    {
+        return stream.GetVertexCount();
+    }
+
+    return 0;
+}
+
+bool PointCloudEngine::OutOfCoreBuilder::ReadChunks(const std::wstring &filename, ChunkFunction function)
+{
+    std::vector<Vertex> vertices(chunkSize);
+
+    if (filename == plyfile)
+    {
+        // Reading the next chunk from the file overlaps with processing this one
+        PlyStream stream(plyfile, chunkSize);
+        size_t count = 0;
+
+        while ((count = stream.NextBatch(vertices.data(), chunkSize)) > 0)
+        {
+            if (IsCancelled())
+            {
+                return false;
+            }
+
+            function(vertices.data(), count);
+        }
+
+        if (stream.Failed())
+        {
+            return false;
+        }
+    }
+    else
+    {
+        // Temporary files store the vertices without any conversion
+        std::ifstream file(filename, std::ios::binary);
+
+        if (!file.is_open())
+        {
+            return false;
+        }
+
+        while (file.read((char*)vertices.data(), chunkSize * sizeof(Vertex)) || (file.gcount() > 0))
+        {
+            if (IsCancelled())
+            {
+                return false;
+            }
+
+            function(vertices.data(), file.gcount() / sizeof(Vertex));
+        }
+    }
+
+    return true;
+}
+
+PointCloudEngine::OctreeNode* PointCloudEngine::OutOfCoreBuilder::BuildCube(const std::wstring &filename, const size_t &vertexCount, const Vector3 &center, const float &size, const int &depth, const UINT64 &id, const int &level)
+{
+    // Cubes that fit into the budget are built in memory, cubes that are leaves cannot be split anymore
+    if ((vertexCount <= maxCubeVertexCount) || !OctreeNode::IsSubdivided(vertexCount, size, depth))
+    {
+        // The chunks are split into the arrays of the points right away, the cube never exists in the vertex format as a whole
+        PointBuffer points;
+        points.Resize(vertexCount);
+        size_t readCount = 0;
+
+        failed |= !ReadChunks(filename, [&](const Vertex *chunk, const size_t &count)
+        {
+            size_t copyCount = min(count, vertexCount - readCount);
+            points.Deinterleave(readCount, copyCount, chunk);
+            readCount += copyCount;
+        });
+
+        points.Resize(readCount);
+
+        if (filename != plyfile)
+        {
+            DeleteFileW(filename.c_str());
+        }
+
+        if (failed || (readCount == 0))
+        {
+            failed = true;
+            return NULL;
+        }
+
+        // Only keep the root node with its cluster summaries for merging, the flat nodes replace the other linked nodes
+        // The other nodes are freed with the arena of the cube
+        MemoryArena cubeArena(scheduler->GetThreadCount());
+        OctreeNode *cubeRoot = nodeArena.Create<OctreeNode>(0, &points, 0, points.GetCount(), center, size, depth, id, &cubeArena, scheduler, progress);
+
+        Octree::Flatten(cubeRoot, level, cubes[cubeRoot], clusteringStatistics);
+
+        for (int i = 0; i < 8; i++)
+        {
+            cubeRoot->children[i] = NULL;
+        }
+
+        return cubeRoot;
+    }
+
+    // Split the vertices into one temporary file per child cube
+    std::wstring childFilenames[8];
+    std::ofstream childFiles[8];
+    size_t childVertexCounts[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+
+    for (int i = 0; i < 8; i++)
+    {
+        childFilenames[i] = GetTemporaryFilename((id << 3) | i);
+        childFiles[i].open(childFilenames[i], std::ios::binary | std::ios::trunc);
+    }
+
+    std::vector<Vertex> sortedChunk(chunkSize);
+
+    failed |= !ReadChunks(filename, [&](const Vertex *chunk, const size_t &count)
+    {
+        // Sort the chunk by the child cubes to write each child range at once
+        size_t childStarts[9] = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+        for (size_t i = 0; i < count; i++)
+        {
+            childStarts[OctreeNode::GetChildIndex(center, chunk[i].position) + 1]++;
+        }
+
+        for (int i = 0; i < 8; i++)
+        {
+            childStarts[i + 1] += childStarts[i];
+        }
+
+        size_t nextFree[8];
+        std::copy(childStarts, childStarts + 8, nextFree);
+
+        for (size_t i = 0; i < count; i++)
+        {
+            sortedChunk[nextFree[OctreeNode::GetChildIndex(center, chunk[i].position)]++] = chunk[i];
+        }
+
+        for (int i = 0; i < 8; i++)
+        {
+            size_t childCount = childStarts[i + 1] - childStarts[i];
+            childFiles[i].write((const char*)(sortedChunk.data() + childStarts[i]), childCount * sizeof(Vertex));
+            childVertexCounts[i] += childCount;
+        }
+    });
+
+    for (int i = 0; i < 8; i++)
+    {
+        childFiles[i].close();
+        failed |= childFiles[i].fail();
+    }
+
+    if (filename != plyfile)
+    {
+        DeleteFileW(filename.c_str());
+    }
+
+    // Build the child cubes one after another, each of them only uses the memory budget by itself
+    OctreeNode *children[8] = { NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL };
+
+    for (int i = 0; i < 8; i++)
+    {
+        if (!failed && (childVertexCounts[i] > 0))
+        {
+            children[i] = BuildCube(childFilenames[i], childVertexCounts[i], OctreeNode::GetChildCenter(center, size, i), size / 2.0f, depth - 1, (id << 3) | i, level + 1);
+        }
+        else
+        {
+            DeleteFileW(childFilenames[i].c_str());
+        }
+    }
+
+    // The coarse nodes are built last from the cluster summaries of their children
+    return nodeArena.Create<OctreeNode>(0, center, size, id, children);
+}
+
+bool PointCloudEngine::OutOfCoreBuilder::IsCancelled()
+{
+    return (progress != NULL) && progress->cancelled;
+}
+
+PointCloudEngine::OutOfCoreBuilder::NodeReference PointCloudEngine::OutOfCoreBuilder::GetNodeReference(OctreeNode *node, const int &level)
+{
+    // The root nodes of the cubes are replaced by the first node of their flat nodes
+    auto cube = cubes.find(node);
+
+    if (cube != cubes.end())
+    {
+        NodeReference reference = { NULL, &cube->second, 0, level };
+        return reference;
+    }
+
+    NodeReference reference = { node, NULL, 0, level };
+    return reference;
+}
+
+std::wstring PointCloudEngine::OutOfCoreBuilder::GetTemporaryFilename(const UINT64 &id)
+{
+    // The node id is unique for each cube
+    return temporaryDirectory + L"/" + std::to_wstring(id) + L".vertices";
+}
+
+std::wstring PointCloudEngine::OutOfCoreBuilder::CreateTemporaryDirectory()
+{
+    // The directory of the executable is often read only (e.g. Program Files), use the temporary folder unless another one is set
+    std::wstring parentDirectory = settings->outOfCoreDirectory;
+
+    if (parentDirectory.empty())
+    {
+        wchar_t temporaryPath[MAX_PATH + 1];
+        DWORD length = GetTempPathW(MAX_PATH + 1, temporaryPath);
+
+        if ((length == 0) || (length > MAX_PATH))
+        {
+            return L"";
+        }
+
+        parentDirectory = std::wstring(temporaryPath, length);
+    }
+
+    // The temporary path ends with a backslash
+    while (!parentDirectory.empty() && ((parentDirectory.back() == L'\\') || (parentDirectory.back() == L'/')))
+    {
+        parentDirectory.pop_back();
+    }
+
+    RemoveStaleDirectories(parentDirectory);
+
+    // The counter makes the name unique for builds of the same process, e.g. the benchmark builds the same file several times
+    static std::atomic<UINT32> buildCounter{ 0 };
+
+    for (int attempt = 0; attempt < 100; attempt++)
+    {
+        std::wstring directory = parentDirectory + L"/" TEMPORARY_DIRECTORY_PREFIX + std::to_wstring(GetCurrentProcessId()) + L"_" + std::to_wstring(buildCounter++);
+
+        if (CreateDirectoryW(directory.c_str(), NULL))
+        {
+            return directory;
+        }
+        else if (GetLastError() != ERROR_ALREADY_EXISTS)
+        {
+            return L"";
+        }
+    }
+
+    return L"";
+}
+
+void PointCloudEngine::OutOfCoreBuilder::RemoveStaleDirectories(const std::wstring &parentDirectory)
+{
+    WIN32_FIND_DATAW directoryData;
+    HANDLE directoryFind = FindFirstFileW((parentDirectory + L"/" TEMPORARY_DIRECTORY_PREFIX L"*").c_str(), &directoryData);
+
+    if (directoryFind == INVALID_HANDLE_VALUE)
+    {
+        return;
+    }
+
+    do
+    {
+        if (!(directoryData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+        {
+            continue;
+        }
+
+        // Processes of other users that are still running can't be opened either, only remove the directory if the process doesn't exist
+        DWORD processId = wcstoul(directoryData.cFileName + wcslen(TEMPORARY_DIRECTORY_PREFIX), NULL, 10);
+        HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, processId);
+
+        if (process != NULL)
+        {
+            CloseHandle(process);
+            continue;
+        }
+        else if (GetLastError() != ERROR_INVALID_PARAMETER)
+        {
+            continue;
+        }
+
+        std::wstring directory = parentDirectory + L"/" + directoryData.cFileName;
+        WIN32_FIND_DATAW fileData;
+        HANDLE fileFind = FindFirstFileW((directory + L"/*.vertices").c_str(), &fileData);
+
+        if (fileFind != INVALID_HANDLE_VALUE)
+        {
+            do
+            {
+                DeleteFileW((directory + L"/" + fileData.cFileName).c_str());
+            } while (FindNextFileW(fileFind, &fileData));
+
+            FindClose(fileFind);
+        }
+
+        RemoveDirectoryW(directory.c_str());
+    } while (FindNextFileW(directoryFind, &directoryData));
+
+    FindClose(directoryFind);
+}
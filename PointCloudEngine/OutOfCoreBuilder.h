@@ -0,0 +1,71 @@
+#ifndef OUTOFCOREBUILDER_H
+#define OUTOFCOREBUILDER_H
+
+#pragma once
+#include "PointCloudEngine.h"
+
+namespace PointCloudEngine
+{
+    // Builds the octree from a binary little endian ply file whose vertices don't fit into memory
+    // The vertices are streamed from the file in chunks and written into one temporary file per child cube of the root
+    // Cubes that still don't fit into settings->outOfCoreMemoryBudget are split the same way again
+    // Each cube that fits is loaded and built in memory, afterwards only its flat nodes and its root node are kept
+    // The coarse nodes above these cubes are built last by merging the cluster summaries of their children
+    class OutOfCoreBuilder
+    {
+    public:
+        OutOfCoreBuilder(const std::wstring &plyfile, BuildProgress *progress = NULL);
+        ~OutOfCoreBuilder();
+
+        // Returns false if the ply file is not supported, a temporary file could not be written or the build was cancelled
+        // The positions and sizes of the nodes follow from the root cube
+        bool Build(const int &depth, std::vector<FlatOctreeNode> &outNodes, std::vector<ClusteringStatistics> &outClusteringStatistics, Vector3 &outRootPosition, float &outRootSize);
+
+        // Amount of vertices in the header of a supported ply file, 0 otherwise
+        static size_t GetVertexCount(const std::wstring &plyfile);
+
+    private:
+        typedef std::function<void(const Vertex *vertices, const size_t &count)> ChunkFunction;
+
+        // Item of the breadth first traversal, either a linked node or a node of the flat nodes of a cube that was built in memory
+        struct NodeReference
+        {
+            OctreeNode *node;
+            const std::vector<FlatOctreeNode> *cubeNodes;
+            UINT32 index;
+            int level;
+        };
+
+        bool ReadChunks(const std::wstring &filename, ChunkFunction function);
+        bool IsCancelled();
+        OctreeNode* BuildCube(const std::wstring &filename, const size_t &vertexCount, const Vector3 &center, const float &size, const int &depth, const UINT64 &id, const int &level);
+        NodeReference GetNodeReference(OctreeNode *node, const int &level);
+        std::wstring GetTemporaryFilename(const UINT64 &id);
+
+        // Creates a new directory with a unique name for the temporary files of this build in settings->outOfCoreDirectory or the temporary folder of the system
+        // The name contains the process id, directories of processes that don't exist anymore are left from crashed builds and are removed first
+        // Returns an empty string if the directory could not be created
+        static std::wstring CreateTemporaryDirectory();
+        static void RemoveStaleDirectories(const std::wstring &parentDirectory);
+
+        std::wstring plyfile;
+        std::wstring temporaryDirectory;
+        bool failed = false;
+        size_t vertexCount = 0;
+
+        // Amount of vertices that are read at once and the largest cube that is built in memory
+        size_t chunkSize = 0;
+        size_t maxCubeVertexCount = 0;
+
+        TaskScheduler *scheduler = NULL;
+        BuildProgress *progress = NULL;
+
+        // Coarse nodes and the root nodes of the cubes, the cubes have their own arenas
+        MemoryArena nodeArena;
+
+        // Flat nodes of each cube that was built in memory, the key is the root node of the cube
+        std::map<OctreeNode*, std::vector<FlatOctreeNode>> cubes;
+        std::vector<ClusteringStatistics> clusteringStatistics;
+    };
+}
+#endif
@@ -0,0 +1,376 @@
+// The reader and stream headers use PlyConverter::Property, the engine header includes them after this class
+#include "PointCloudEngine.h"
+
+void PointCloudEngine::PlyConverter::Convert(const Source &positions, const Source &normals, const Source &colors, const size_t &count, Vertex *outVertices)
+{
+    Destination destination = { &outVertices->position, &outVertices->normal, outVertices->color, sizeof(Vertex), sizeof(Vertex) };
+    Convert(positions, normals, colors, count, destination);
+}
+
+void PointCloudEngine::PlyConverter::Convert(const byte *data, const size_t &stride, const Property properties[9], const size_t &count, Vertex *outVertices)
+{
+    Source sources[3];
+    GetSources(data, stride, properties, sources);
+
+    Convert(sources[0], sources[1], sources[2], count, outVertices);
+}
+
+void PointCloudEngine::PlyConverter::Convert(const Source &positions, const Source &normals, const Source &colors, const size_t &count, PointBuffer &outPoints, const size_t &first)
+{
+    Destination destination = { outPoints.GetPositions() + first, outPoints.GetNormals() + first, outPoints.GetColors() + 3 * first, sizeof(Vector3), 3 };
+    Convert(positions, normals, colors, count, destination);
+}
+
+void PointCloudEngine::PlyConverter::Convert(const byte *data, const size_t &stride, const Property properties[9], const size_t &count, PointBuffer &outPoints, const size_t &first)
+{
+    Source sources[3];
+    GetSources(data, stride, properties, sources);
+
+    Convert(sources[0], sources[1], sources[2], count, outPoints, first);
+}
+
+bool PointCloudEngine::PlyConverter::ParseHeader(const char *text, const size_t &size, Header &outHeader)
+{
+    // Same property names as in LoadPlyFileWithTinyply
+    static const std::string propertyNames[9] = { "x", "y", "z", "nx", "ny", "nz", "red", "green", "blue" };
+    static const std::map<std::string, tinyply::Type> typeNames =
+    {
+        { "char", tinyply::Type::INT8 }, { "int8", tinyply::Type::INT8 },
+        { "uchar", tinyply::Type::UINT8 }, { "uint8", tinyply::Type::UINT8 },
+        { "short", tinyply::Type::INT16 }, { "int16", tinyply::Type::INT16 },
+        { "ushort", tinyply::Type::UINT16 }, { "uint16", tinyply::Type::UINT16 },
+        { "int", tinyply::Type::INT32 }, { "int32", tinyply::Type::INT32 },
+        { "uint", tinyply::Type::UINT32 }, { "uint32", tinyply::Type::UINT32 },
+        { "float", tinyply::Type::FLOAT32 }, { "float32", tinyply::Type::FLOAT32 },
+        { "double", tinyply::Type::FLOAT64 }, { "float64", tinyply::Type::FLOAT64 }
+    };
+
+    Header header;
+    size_t position = 0;
+    bool vertexElement = false;
+    int elementCount = 0;
+    int lineCount = 0;
+
+    while ((header.dataStart == 0) && (position < size))
+    {
+        const char *lineEnd = (const char*)memchr(text + position, '\n', size - position);
+
+        if (lineEnd == NULL)
+        {
+            return false;
+        }
+
+        std::string line(text + position, lineEnd);
+        position = (lineEnd - text) + 1;
+
+        // Files with windows line endings
+        if (!line.empty() && (line.back() == '\r'))
+        {
+            line.pop_back();
+        }
+
+        std::istringstream lineStream(line);
+        std::string token;
+        lineStream >> token;
+
+        if ((lineCount++ == 0) && (token != "ply"))
+        {
+            return false;
+        }
+
+        if (token == "format")
+        {
+            lineStream >> header.format;
+        }
+        else if (token == "element")
+        {
+            // The vertex element has to be the first element, otherwise the size of the elements before it can be unknown (lists)
+            std::string name;
+            size_t count = 0;
+            lineStream >> name >> count;
+
+            vertexElement = (name == "vertex") && (elementCount == 0);
+            elementCount++;
+
+            if (vertexElement)
+            {
+                header.vertexCount = count;
+            }
+        }
+        else if ((token == "property") && vertexElement)
+        {
+            std::string typeName, name;
+            lineStream >> typeName >> name;
+
+            auto type = typeNames.find(typeName);
+
+            if (type == typeNames.end())
+            {
+                return false;
+            }
+
+            for (int i = 0; i < 9; i++)
+            {
+                if (name == propertyNames[i])
+                {
+                    header.properties[i].offset = header.vertexStride;
+                    header.properties[i].type = type->second;
+                    header.columns[i] = header.columnCount;
+                }
+            }
+
+            header.vertexStride += tinyply::PropertyTable[type->second].stride;
+            header.columnCount++;
+        }
+        else if (token == "end_header")
+        {
+            header.dataStart = position;
+        }
+    }
+
+    if ((header.vertexCount == 0) || (header.dataStart == 0))
+    {
+        return false;
+    }
+
+    for (int i = 0; i < 9; i++)
+    {
+        if (header.properties[i].offset < 0)
+        {
+            return false;
+        }
+    }
+
+    outHeader = header;
+
+    return true;
+}
+
+byte PointCloudEngine::PlyConverter::ConvertColor(const double &value, const tinyply::Type &type)
+{
+    switch (type)
+    {
+        case tinyply::Type::INT8: return ConvertColor<INT8>(value);
+        case tinyply::Type::UINT8: return ConvertColor<UINT8>(value);
+        case tinyply::Type::INT16: return ConvertColor<INT16>(value);
+        case tinyply::Type::UINT16: return ConvertColor<UINT16>(value);
+        case tinyply::Type::INT32: return ConvertColor<INT32>(value);
+        case tinyply::Type::UINT32: return ConvertColor<UINT32>(value);
+        case tinyply::Type::FLOAT32: return ConvertValue<float, byte>((float)value);
+        case tinyply::Type::FLOAT64: return ConvertValue<double, byte>(value);
+    }
+
+    return ConvertColor<UINT8>(value);
+}
+
+void PointCloudEngine::PlyConverter::Convert(const Source &positions, const Source &normals, const Source &colors, const size_t &count, const Destination &destination)
+{
+    // The source records and the converted points of a block fit into the L2 cache
+    const size_t blockSize = 1024;
+
+    for (size_t first = 0; first < count; first += blockSize)
+    {
+        size_t blockCount = min(blockSize, count - first);
+        Vector3 *blockPositions = (Vector3*)((byte*)destination.positions + first * destination.vectorStride);
+        Vector3 *blockNormals = (Vector3*)((byte*)destination.normals + first * destination.vectorStride);
+        byte *blockColors = destination.colors + first * destination.colorStride;
+
+        ConvertAttribute(positions, first, blockCount, &blockPositions->x, destination.vectorStride);
+        ConvertAttribute(normals, first, blockCount, &blockNormals->x, destination.vectorStride);
+        ConvertAttribute(colors, first, blockCount, blockColors, destination.colorStride);
+
+        // Make sure that the normals are normalized
+        for (size_t i = 0; i < blockCount; i++)
+        {
+            ((Vector3*)((byte*)blockNormals + i * destination.vectorStride))->Normalize();
+        }
+    }
+}
+
+void PointCloudEngine::PlyConverter::GetSources(const byte *data, const size_t &stride, const Property properties[9], Source outSources[3])
+{
+    for (int i = 0; i < 3; i++)
+    {
+        outSources[i].data = data;
+        outSources[i].stride = stride;
+        std::copy(properties + 3 * i, properties + 3 * i + 3, outSources[i].properties);
+    }
+}
+
+// Positions and normals keep their values
+template <typename S, typename D> D PointCloudEngine::PlyConverter::ConvertValue(const S &value)
+{
+    return (D)value;
+}
+
+// Signed colors are clamped to 0 and then converted like the unsigned type of the same size
+template <> byte PointCloudEngine::PlyConverter::ConvertValue<INT8, byte>(const INT8 &value)
+{
+    return ConvertValue<UINT8, byte>((UINT8)max(value, (INT8)0));
+}
+
+template <> byte PointCloudEngine::PlyConverter::ConvertValue<UINT8, byte>(const UINT8 &value)
+{
+    return value;
+}
+
+template <> byte PointCloudEngine::PlyConverter::ConvertValue<INT16, byte>(const INT16 &value)
+{
+    return ConvertValue<UINT16, byte>((UINT16)max(value, (INT16)0));
+}
+
+template <> byte PointCloudEngine::PlyConverter::ConvertValue<UINT16, byte>(const UINT16 &value)
+{
+    return value >> 8;
+}
+
+template <> byte PointCloudEngine::PlyConverter::ConvertValue<INT32, byte>(const INT32 &value)
+{
+    return ConvertValue<UINT32, byte>((UINT32)max(value, 0));
+}
+
+template <> byte PointCloudEngine::PlyConverter::ConvertValue<UINT32, byte>(const UINT32 &value)
+{
+    return min(value, 255u);
+}
+
+template <> byte PointCloudEngine::PlyConverter::ConvertValue<float, byte>(const float &value)
+{
+    // Also maps NaN to 0, the same as the vectorized version
+    float scaled = value * 255.0f;
+    return (scaled > 0.0f) ? (byte)(min(scaled, 255.0f) + 0.5f) : 0;
+}
+
+template <> byte PointCloudEngine::PlyConverter::ConvertValue<double, byte>(const double &value)
+{
+    return ConvertValue<float, byte>((float)value);
+}
+
+template <typename S> byte PointCloudEngine::PlyConverter::ConvertColor(const double &value)
+{
+    // Casting a double outside of the range of an integer type is undefined, NaN becomes the lowest value
+    const double lowest = (double)std::numeric_limits<S>::lowest();
+    const double highest = (double)(std::numeric_limits<S>::max)();
+
+    return ConvertValue<S, byte>((value > lowest) ? ((value < highest) ? (S)value : (S)highest) : (S)lowest);
+}
+
+template <typename S, typename D> void PointCloudEngine::PlyConverter::ConvertComponent(const byte *data, const size_t &stride, const size_t &count, D *destination, const size_t &destinationStride)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        // Ply records are packed without alignment
+        S value;
+        memcpy(&value, data + i * stride, sizeof(S));
+
+        *(D*)((byte*)destination + i * destinationStride) = ConvertValue<S, D>(value);
+    }
+}
+
+template <typename S, typename D> void PointCloudEngine::PlyConverter::ConvertPacked(const byte *data, const size_t &stride, const size_t &count, D *destination, const size_t &destinationStride)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        S values[3];
+        memcpy(values, data + i * stride, sizeof(values));
+
+        D *pointDestination = (D*)((byte*)destination + i * destinationStride);
+        pointDestination[0] = ConvertValue<S, D>(values[0]);
+        pointDestination[1] = ConvertValue<S, D>(values[1]);
+        pointDestination[2] = ConvertValue<S, D>(values[2]);
+    }
+}
+
+template <> void PointCloudEngine::PlyConverter::ConvertPacked<float, float>(const byte *data, const size_t &stride, const size_t &count, float *destination, const size_t &destinationStride)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        memcpy((byte*)destination + i * destinationStride, data + i * stride, 3 * sizeof(float));
+    }
+}
+
+template <> void PointCloudEngine::PlyConverter::ConvertPacked<UINT8, byte>(const byte *data, const size_t &stride, const size_t &count, byte *destination, const size_t &destinationStride)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        memcpy(destination + i * destinationStride, data + i * stride, 3);
+    }
+}
+
+template <> void PointCloudEngine::PlyConverter::ConvertPacked<double, float>(const byte *data, const size_t &stride, const size_t &count, float *destination, const size_t &destinationStride)
+{
+    // Converts x and y together and z separately, never reads past the 3 doubles of the last record
+    for (size_t i = 0; i < count; i++)
+    {
+        const double *values = (const double*)(data + i * stride);
+        float *pointDestination = (float*)((byte*)destination + i * destinationStride);
+
+        _mm_storel_pi((__m64*)pointDestination, _mm_cvtpd_ps(_mm_loadu_pd(values)));
+        _mm_store_ss(pointDestination + 2, _mm_cvtsd_ss(_mm_setzero_ps(), _mm_load_sd(values + 2)));
+    }
+}
+
+template <> void PointCloudEngine::PlyConverter::ConvertPacked<float, byte>(const byte *data, const size_t &stride, const size_t &count, byte *destination, const size_t &destinationStride)
+{
+    // Same operations as the scalar version, the maximum with zero as second operand maps NaN to 0
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 scale = _mm_set1_ps(255.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const float *values = (const float*)(data + i * stride);
+        __m128 scaled = _mm_max_ps(_mm_mul_ps(_mm_setr_ps(values[0], values[1], values[2], 0.0f), scale), zero);
+        __m128i rounded = _mm_cvttps_epi32(_mm_add_ps(_mm_min_ps(scaled, scale), half));
+
+        // Pack the 32 bit integers into the lowest 4 bytes
+        rounded = _mm_packus_epi16(_mm_packs_epi32(rounded, rounded), rounded);
+        int packed = _mm_cvtsi128_si32(rounded);
+        memcpy(destination + i * destinationStride, &packed, 3);
+    }
+}
+
+template <typename D> void PointCloudEngine::PlyConverter::ConvertAttribute(const Source &source, const size_t &first, const size_t &count, D *destination, const size_t &destinationStride)
+{
+    const byte *data = source.data + first * source.stride;
+    const Property *properties = source.properties;
+
+    // The common layout converts all 3 properties at once
+    bool packed = (properties[1].type == properties[0].type) && (properties[2].type == properties[0].type);
+    packed &= (properties[1].offset == properties[0].offset + tinyply::PropertyTable[properties[0].type].stride);
+    packed &= (properties[2].offset == properties[1].offset + tinyply::PropertyTable[properties[0].type].stride);
+
+    if (packed)
+    {
+        const byte *propertyData = data + properties[0].offset;
+
+        switch (properties[0].type)
+        {
+            case tinyply::Type::INT8: ConvertPacked<INT8, D>(propertyData, source.stride, count, destination, destinationStride); return;
+            case tinyply::Type::UINT8: ConvertPacked<UINT8, D>(propertyData, source.stride, count, destination, destinationStride); return;
+            case tinyply::Type::INT16: ConvertPacked<INT16, D>(propertyData, source.stride, count, destination, destinationStride); return;
+            case tinyply::Type::UINT16: ConvertPacked<UINT16, D>(propertyData, source.stride, count, destination, destinationStride); return;
+            case tinyply::Type::INT32: ConvertPacked<INT32, D>(propertyData, source.stride, count, destination, destinationStride); return;
+            case tinyply::Type::UINT32: ConvertPacked<UINT32, D>(propertyData, source.stride, count, destination, destinationStride); return;
+            case tinyply::Type::FLOAT32: ConvertPacked<float, D>(propertyData, source.stride, count, destination, destinationStride); return;
+            case tinyply::Type::FLOAT64: ConvertPacked<double, D>(propertyData, source.stride, count, destination, destinationStride); return;
+        }
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        const byte *propertyData = data + properties[i].offset;
+
+        switch (properties[i].type)
+        {
+            case tinyply::Type::INT8: ConvertComponent<INT8, D>(propertyData, source.stride, count, destination + i, destinationStride); break;
+            case tinyply::Type::UINT8: ConvertComponent<UINT8, D>(propertyData, source.stride, count, destination + i, destinationStride); break;
+            case tinyply::Type::INT16: ConvertComponent<INT16, D>(propertyData, source.stride, count, destination + i, destinationStride); break;
+            case tinyply::Type::UINT16: ConvertComponent<UINT16, D>(propertyData, source.stride, count, destination + i, destinationStride); break;
+            case tinyply::Type::INT32: ConvertComponent<INT32, D>(propertyData, source.stride, count, destination + i, destinationStride); break;
+            case tinyply::Type::UINT32: ConvertComponent<UINT32, D>(propertyData, source.stride, count, destination + i, destinationStride); break;
+            case tinyply::Type::FLOAT32: ConvertComponent<float, D>(propertyData, source.stride, count, destination + i, destinationStride); break;
+            case tinyply::Type::FLOAT64: ConvertComponent<double, D>(propertyData, source.stride, count, destination + i, destinationStride); break;
+        }
+    }
+}
@@ -0,0 +1,103 @@
+#ifndef PLYCONVERTER_H
+#define PLYCONVERTER_H
+
+#pragma once
+#include "PointCloudEngine.h"
+
+namespace PointCloudEngine
+{
+    // Converts ply properties of any numeric type into the vertex format
+    // Positions and normals are converted to float, float colors in [0, 1] are scaled up to [0, 255]
+    // 8 bit colors are kept, 16 bit colors keep their high byte and 32 bit colors are clamped to 255, signed colors are clamped to 0 first
+    // There is one converter for each pair of source and destination type, the common layouts (3 consecutive properties of the same type) have vectorized versions
+    // The output is either the interleaved vertex format or the separate arrays of a point buffer
+    class PlyConverter
+    {
+    public:
+        // Byte offset and type of a property within one record of the source data
+        struct Property
+        {
+            int offset = -1;
+            tinyply::Type type = tinyply::Type::INVALID;
+        };
+
+        // Records with the 3 properties of one attribute, e.g. x, y, z or red, green, blue
+        struct Source
+        {
+            const byte *data = NULL;
+            size_t stride = 0;
+            Property properties[3];
+        };
+
+        // Layout of the vertex element of a ply file, the properties are x, y, z, nx, ny, nz, red, green, blue
+        struct Header
+        {
+            // E.g. ascii or binary_little_endian, the readers check if they support it
+            std::string format;
+            size_t vertexCount = 0;
+            size_t vertexStride = 0;
+            int columnCount = 0;
+
+            // Offset of the first byte after the header in the file
+            size_t dataStart = 0;
+
+            // Byte offsets in binary records and column indices in text lines
+            Property properties[9];
+            int columns[9] = { -1, -1, -1, -1, -1, -1, -1, -1, -1 };
+        };
+
+        // Parses the header at the start of the text, both type names of the ply format are supported
+        // Returns false if the text doesn't contain a complete header or the vertex element isn't the first element or misses one of the properties
+        static bool ParseHeader(const char *text, const size_t &size, Header &outHeader);
+
+        // Converts positions, normals and colors in blocks that stay in the cache and normalizes the normals of each block right after converting them
+        static void Convert(const Source &positions, const Source &normals, const Source &colors, const size_t &count, Vertex *outVertices);
+
+        // Interleaved records with the properties x, y, z, nx, ny, nz, red, green, blue
+        static void Convert(const byte *data, const size_t &stride, const Property properties[9], const size_t &count, Vertex *outVertices);
+
+        // Same for point buffers, the points are written starting at the index first
+        static void Convert(const Source &positions, const Source &normals, const Source &colors, const size_t &count, PointBuffer &outPoints, const size_t &first);
+        static void Convert(const byte *data, const size_t &stride, const Property properties[9], const size_t &count, PointBuffer &outPoints, const size_t &first);
+
+        // Converts a color of a text file with the same rules as a binary color of this type, the value is clamped to the range of the type first
+        static byte ConvertColor(const double &value, const tinyply::Type &type);
+
+    private:
+        // Where the converted attributes of the first point go and the distances in bytes to the next point
+        struct Destination
+        {
+            Vector3 *positions;
+            Vector3 *normals;
+            byte *colors;
+            size_t vectorStride;
+            size_t colorStride;
+        };
+
+        static void Convert(const Source &positions, const Source &normals, const Source &colors, const size_t &count, const Destination &destination);
+        static void GetSources(const byte *data, const size_t &stride, const Property properties[9], Source outSources[3]);
+
+        template <typename D> static void ConvertAttribute(const Source &source, const size_t &first, const size_t &count, D *destination, const size_t &destinationStride);
+        template <typename S, typename D> static D ConvertValue(const S &value);
+        template <typename S> static byte ConvertColor(const double &value);
+        template <typename S, typename D> static void ConvertComponent(const byte *data, const size_t &stride, const size_t &count, D *destination, const size_t &destinationStride);
+        template <typename S, typename D> static void ConvertPacked(const byte *data, const size_t &stride, const size_t &count, D *destination, const size_t &destinationStride);
+    };
+
+    // The explicit specializations have to be declared before the converters are instantiated
+    // The color conversions of the signed types clamp to 0 and then use the unsigned type of the same size, e.g. INT16 300 becomes 1 like UINT16 300
+    template <> byte PlyConverter::ConvertValue<INT8, byte>(const INT8 &value);
+    template <> byte PlyConverter::ConvertValue<UINT8, byte>(const UINT8 &value);
+    template <> byte PlyConverter::ConvertValue<INT16, byte>(const INT16 &value);
+    template <> byte PlyConverter::ConvertValue<UINT16, byte>(const UINT16 &value);
+    template <> byte PlyConverter::ConvertValue<INT32, byte>(const INT32 &value);
+    template <> byte PlyConverter::ConvertValue<UINT32, byte>(const UINT32 &value);
+    template <> byte PlyConverter::ConvertValue<float, byte>(const float &value);
+    template <> byte PlyConverter::ConvertValue<double, byte>(const double &value);
+
+    template <> void PlyConverter::ConvertPacked<float, float>(const byte *data, const size_t &stride, const size_t &count, float *destination, const size_t &destinationStride);
+    template <> void PlyConverter::ConvertPacked<UINT8, byte>(const byte *data, const size_t &stride, const size_t &count, byte *destination, const size_t &destinationStride);
+    template <> void PlyConverter::ConvertPacked<double, float>(const byte *data, const size_t &stride, const size_t &count, float *destination, const size_t &destinationStride);
+    template <> void PlyConverter::ConvertPacked<float, byte>(const byte *data, const size_t &stride, const size_t &count, byte *destination, const size_t &destinationStride);
+}
+#endif
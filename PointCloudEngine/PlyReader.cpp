@@ -0,0 +1,583 @@
+#include "PlyReader.h"
+
+PointCloudEngine::PlyReader::PlyReader(const std::wstring &plyfile)
+{
+    file = CreateFileW(plyfile.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return;
+    }
+
+    LARGE_INTEGER size;
+
+    // The whole file is mapped at once, 32 bit builds cannot map files that are larger than the address space
+    if (!GetFileSizeEx(file, &size) || (size.QuadPart == 0) || ((UINT64)size.QuadPart > (UINT64)SIZE_MAX))
+    {
+        return;
+    }
+
+    fileSize = size.QuadPart;
+    mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+    if (mapping == NULL)
+    {
+        return;
+    }
+
+    view = (const byte*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+    if (view == NULL)
+    {
+        return;
+    }
+
+    // Column files have no header, their extension is the only way to recognize them
+    std::wstring extension = plyfile.substr(plyfile.find_last_of(L'.') + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(), towlower);
+
+    if ((extension == L"xyz") || (extension == L"pts"))
+    {
+        format = Format::Columns;
+        valid = ParseColumnLayout();
+    }
+    else
+    {
+        valid = ParseHeader();
+    }
+}
+
+PointCloudEngine::PlyReader::~PlyReader()
+{
+    if (view != NULL)
+    {
+        UnmapViewOfFile(view);
+    }
+
+    if (mapping != NULL)
+    {
+        CloseHandle(mapping);
+    }
+
+    if (file != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(file);
+    }
+}
+
+bool PointCloudEngine::PlyReader::IsValid()
+{
+    return valid;
+}
+
+size_t PointCloudEngine::PlyReader::GetVertexCount()
+{
+    return vertexCount;
+}
+
+UINT64 PointCloudEngine::PlyReader::GetFileSize()
+{
+    return fileSize;
+}
+
+bool PointCloudEngine::PlyReader::ReadVertices(PointBuffer &outPoints, BuildProgress *progress)
+{
+    if (!valid)
+    {
+        return false;
+    }
+
+    if (progress != NULL)
+    {
+        progress->readByteCount = vertexData - view;
+        progress->fileByteCount = fileSize;
+    }
+
+    TaskScheduler scheduler(settings->buildThreadCount);
+
+    if (format == Format::BinaryLittleEndian)
+    {
+        return ReadBinaryVertices(outPoints, scheduler, progress);
+    }
+
+    return ReadTextVertices(outPoints, scheduler, progress);
+}
+
+bool PointCloudEngine::PlyReader::ReadBinaryVertices(PointBuffer &outPoints, TaskScheduler &scheduler, BuildProgress *progress)
+{
+    // When this throws an std::bad_alloc exception, the memory requirement is large -> build with x64
+    outPoints.Resize(vertexCount);
+
+    // The vertices are converted in blocks of about 64MB of the file, the progress is updated and the cancellation is checked after each block
+    size_t blockSize = max((size_t)1, (size_t)(64 * 1024 * 1024) / vertexStride);
+
+    for (size_t blockStart = 0; blockStart < vertexCount; blockStart += blockSize)
+    {
+        if ((progress != NULL) && progress->cancelled)
+        {
+            return false;
+        }
+
+        size_t blockCount = min(blockSize, vertexCount - blockStart);
+
+        // Each thread converts a consecutive range, the operating system reads the pages of the mapped file on the first access
+        scheduler.ParallelFor(blockCount, [&](const int &chunk, const size_t &begin, const size_t &end)
+        {
+            PlyConverter::Convert(vertexData + (blockStart + begin) * vertexStride, vertexStride, properties, end - begin, outPoints, blockStart + begin);
+        });
+
+        if (progress != NULL)
+        {
+            progress->readByteCount += blockCount * vertexStride;
+        }
+    }
+
+    return true;
+}
+
+bool PointCloudEngine::PlyReader::ReadTextVertices(PointBuffer &outPoints, TaskScheduler &scheduler, BuildProgress *progress)
+{
+    const char *textStart = (const char*)vertexData;
+    const char *textEnd = (const char*)view + fileSize;
+
+    // Split the text into one chunk per thread, each chunk starts after a line break
+    int chunkCount = scheduler.GetThreadCount();
+    std::vector<const char*> chunkStarts(chunkCount + 1);
+    chunkStarts[0] = textStart;
+    chunkStarts[chunkCount] = textEnd;
+
+    for (int i = 1; i < chunkCount; i++)
+    {
+        const char *position = max(chunkStarts[i - 1], textStart + ((textEnd - textStart) / chunkCount) * i);
+        const char *lineEnd = (const char*)memchr(position, '\n', textEnd - position);
+        chunkStarts[i] = (lineEnd == NULL) ? textEnd : lineEnd + 1;
+    }
+
+    // Every few thousand lines the cancellation is checked, the parsing pass also adds the bytes of these lines to the progress
+    auto forEachLine = [&](const size_t &chunk, const bool &reportProgress, auto function)
+    {
+        const char *chunkEnd = chunkStarts[chunk + 1];
+        const char *reportStart = chunkStarts[chunk];
+        size_t lineCount = 0;
+
+        for (const char *lineStart = chunkStarts[chunk]; lineStart < chunkEnd;)
+        {
+            const char *lineEnd = (const char*)memchr(lineStart, '\n', chunkEnd - lineStart);
+
+            if (lineEnd == NULL)
+            {
+                lineEnd = chunkEnd;
+            }
+
+            if (IsVertexLine(lineStart, lineEnd) && !function(lineStart, lineEnd))
+            {
+                return;
+            }
+
+            lineStart = lineEnd + 1;
+
+            if ((progress != NULL) && (++lineCount % 4096 == 0))
+            {
+                if (progress->cancelled)
+                {
+                    return;
+                }
+
+                if (reportProgress)
+                {
+                    progress->readByteCount += min(lineStart, chunkEnd) - reportStart;
+                    reportStart = min(lineStart, chunkEnd);
+                }
+            }
+        }
+
+        if ((progress != NULL) && reportProgress)
+        {
+            progress->readByteCount += chunkEnd - reportStart;
+        }
+    };
+
+    // Count the vertex lines of each chunk, the vertices of a chunk start after the vertices of all the chunks before it
+    std::vector<size_t> chunkVertexStarts(chunkCount + 1, 0);
+
+    scheduler.ParallelFor(chunkCount, [&](const int &thread, const size_t &begin, const size_t &end)
+    {
+        for (size_t chunk = begin; chunk < end; chunk++)
+        {
+            forEachLine(chunk, false, [&](const char *lineStart, const char *lineEnd)
+            {
+                chunkVertexStarts[chunk + 1]++;
+                return true;
+            });
+        }
+    });
+
+    if ((progress != NULL) && progress->cancelled)
+    {
+        return false;
+    }
+
+    for (int i = 0; i < chunkCount; i++)
+    {
+        chunkVertexStarts[i + 1] += chunkVertexStarts[i];
+    }
+
+    // Lines after the vertices of ascii ply files belong to other elements
+    size_t count = (format == Format::Ascii) ? vertexCount : chunkVertexStarts[chunkCount];
+
+    if (chunkVertexStarts[chunkCount] < count)
+    {
+        return false;
+    }
+
+    // When this throws an std::bad_alloc exception, the memory requirement is large -> build with x64
+    outPoints.Resize(count);
+    std::atomic<bool> failed(false);
+
+    scheduler.ParallelFor(chunkCount, [&](const int &thread, const size_t &begin, const size_t &end)
+    {
+        for (size_t chunk = begin; chunk < end; chunk++)
+        {
+            size_t index = chunkVertexStarts[chunk];
+
+            forEachLine(chunk, true, [&](const char *lineStart, const char *lineEnd)
+            {
+                if (index >= count)
+                {
+                    return false;
+                }
+
+                if (!ParseVertexLine(lineStart, lineEnd, outPoints, index++))
+                {
+                    failed = true;
+                    return false;
+                }
+
+                return true;
+            });
+        }
+    });
+
+    return !failed && ((progress == NULL) || !progress->cancelled);
+}
+
+bool PointCloudEngine::PlyReader::ParseHeader()
+{
+    PlyConverter::Header header;
+
+    if (!PlyConverter::ParseHeader((const char*)view, fileSize, header))
+    {
+        return false;
+    }
+
+    if (header.format == "ascii")
+    {
+        format = Format::Ascii;
+    }
+    else if (header.format != "binary_little_endian")
+    {
+        return false;
+    }
+
+    vertexCount = header.vertexCount;
+    vertexStride = header.vertexStride;
+    vertexData = view + header.dataStart;
+    std::copy(header.properties, header.properties + 9, properties);
+
+    if (format == Format::Ascii)
+    {
+        columnProperties.resize(header.columnCount, -1);
+
+        for (int i = 0; i < 9; i++)
+        {
+            properties[i].offset = header.columns[i];
+            columnProperties[header.columns[i]] = i;
+        }
+
+        return true;
+    }
+
+    // Truncated files
+    return (fileSize - header.dataStart) / vertexStride >= vertexCount;
+}
+
+bool PointCloudEngine::PlyReader::ParseColumnLayout()
+{
+    const char *text = (const char*)view;
+    const char *textEnd = text + fileSize;
+
+    // The first line with at least 3 columns defines the layout of all the lines
+    std::vector<std::pair<const char*, const char*>> columns;
+
+    for (const char *lineStart = text; (lineStart < textEnd) && columns.empty();)
+    {
+        const char *lineEnd = (const char*)memchr(lineStart, '\n', textEnd - lineStart);
+
+        if (lineEnd == NULL)
+        {
+            lineEnd = textEnd;
+        }
+
+        if (IsVertexLine(lineStart, lineEnd))
+        {
+            for (const char *position = SkipWhitespace(lineStart, lineEnd); position < lineEnd; position = SkipWhitespace(position, lineEnd))
+            {
+                const char *tokenEnd = SkipToken(position, lineEnd);
+                columns.push_back(std::make_pair(position, tokenEnd));
+                position = tokenEnd;
+            }
+        }
+
+        lineStart = lineEnd + 1;
+    }
+
+    if (columns.empty())
+    {
+        return false;
+    }
+
+    // Colors are written as integers, normals are written with a decimal point
+    auto isInteger = [&](const int &firstColumn)
+    {
+        for (int i = firstColumn; i < firstColumn + 3; i++)
+        {
+            if (std::find_if(columns[i].first, columns[i].second, [](const char &c) { return (c < '0') || (c > '9'); }) != columns[i].second)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    };
+
+    // x y z, x y z intensity, x y z r g b, x y z nx ny nz, x y z intensity r g b (pts), x y z r g b nx ny nz, x y z nx ny nz r g b, x y z intensity r g b nx ny nz
+    int colorColumn = -1;
+    int normalColumn = -1;
+
+    if (columns.size() == 6)
+    {
+        (isInteger(3) ? colorColumn : normalColumn) = 3;
+    }
+    else if ((columns.size() == 7) || (columns.size() == 8))
+    {
+        colorColumn = 4;
+    }
+    else if (columns.size() == 9)
+    {
+        colorColumn = isInteger(3) ? 3 : 6;
+        normalColumn = isInteger(3) ? 6 : 3;
+    }
+    else if (columns.size() >= 10)
+    {
+        colorColumn = 4;
+        normalColumn = 7;
+    }
+
+    // There are no property types, the colors are written as integers in [0, 255]
+    for (int i = 0; i < 3; i++)
+    {
+        properties[i].offset = i;
+        properties[3 + i].offset = (normalColumn < 0) ? -1 : normalColumn + i;
+        properties[6 + i].offset = (colorColumn < 0) ? -1 : colorColumn + i;
+        properties[i].type = properties[3 + i].type = tinyply::Type::FLOAT64;
+        properties[6 + i].type = tinyply::Type::UINT8;
+    }
+
+    columnProperties.resize(max(3, max(normalColumn, colorColumn) + 3), -1);
+
+    for (int i = 0; i < 9; i++)
+    {
+        if (properties[i].offset >= 0)
+        {
+            columnProperties[properties[i].offset] = i;
+        }
+    }
+
+    vertexData = view;
+
+    return true;
+}
+
+bool PointCloudEngine::PlyReader::IsVertexLine(const char *begin, const char *end)
+{
+    const char *position = SkipWhitespace(begin, end);
+
+    if (position == end)
+    {
+        return false;
+    }
+
+    if (format == Format::Ascii)
+    {
+        return true;
+    }
+
+    if ((*position == '#') || (*position == '/'))
+    {
+        return false;
+    }
+
+    int columnCount = 0;
+
+    while ((position < end) && (columnCount < 3))
+    {
+        position = SkipWhitespace(SkipToken(position, end), end);
+        columnCount++;
+    }
+
+    return columnCount >= 3;
+}
+
+bool PointCloudEngine::PlyReader::ParseVertexLine(const char *begin, const char *end, PointBuffer &outPoints, const size_t &index)
+{
+    // Missing normals are zero and missing colors are white
+    double values[9] = { 0, 0, 0, 0, 0, 0, 255, 255, 255 };
+    const char *position = SkipWhitespace(begin, end);
+
+    for (size_t column = 0; column < columnProperties.size(); column++)
+    {
+        if (position == end)
+        {
+            return false;
+        }
+
+        const char *tokenEnd = SkipToken(position, end);
+        int property = columnProperties[column];
+
+        if ((property >= 0) && !ParseNumber(position, tokenEnd, values[property]))
+        {
+            return false;
+        }
+
+        position = SkipWhitespace(tokenEnd, end);
+    }
+
+    Vector3 &normal = outPoints.GetNormals()[index];
+    byte *color = outPoints.GetColors() + 3 * index;
+
+    outPoints.GetPositions()[index] = Vector3(values[0], values[1], values[2]);
+    normal = Vector3(values[3], values[4], values[5]);
+
+    // Same conversion as for binary colors of the property type, e.g. float colors in [0, 1] are scaled up
+    for (int i = 0; i < 3; i++)
+    {
+        color[i] = PlyConverter::ConvertColor(values[6 + i], properties[6 + i].type);
+    }
+
+    // Make sure that the normals are normalized
+    normal.Normalize();
+
+    return true;
+}
+
+bool PointCloudEngine::PlyReader::ParseNumber(const char *begin, const char *end, double &outValue)
+{
+    // Doubles represent all integers up to 2^53 and powers of ten up to 10^22 exactly, one operation on them is correctly rounded
+    static const double powersOfTen[23] =
+    {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    const char *position = begin;
+    bool negative = false;
+
+    if ((position < end) && ((*position == '-') || (*position == '+')))
+    {
+        negative = (*position == '-');
+        position++;
+    }
+
+    UINT64 mantissa = 0;
+    int significantDigits = 0;
+    int exponent = 0;
+    bool digits = false;
+
+    for (; (position < end) && (*position >= '0') && (*position <= '9'); position++)
+    {
+        mantissa = 10 * mantissa + (*position - '0');
+        significantDigits += (mantissa > 0);
+        digits = true;
+    }
+
+    if ((position < end) && (*position == '.'))
+    {
+        for (position++; (position < end) && (*position >= '0') && (*position <= '9'); position++)
+        {
+            mantissa = 10 * mantissa + (*position - '0');
+            significantDigits += (mantissa > 0);
+            exponent--;
+            digits = true;
+        }
+    }
+
+    if (digits && (position < end) && ((*position == 'e') || (*position == 'E')))
+    {
+        position++;
+        bool negativeExponent = false;
+
+        if ((position < end) && ((*position == '-') || (*position == '+')))
+        {
+            negativeExponent = (*position == '-');
+            position++;
+        }
+
+        int exponentValue = 0;
+        digits = false;
+
+        for (; (position < end) && (*position >= '0') && (*position <= '9'); position++)
+        {
+            exponentValue = min(10 * exponentValue + (*position - '0'), 100000);
+            digits = true;
+        }
+
+        exponent += negativeExponent ? -exponentValue : exponentValue;
+    }
+
+    // The mantissa cannot overflow with at most 19 significant digits
+    if (digits && (position == end) && (significantDigits <= 19) && (mantissa <= (1ull << 53)) && (exponent >= -22) && (exponent <= 22))
+    {
+        double value = (double)mantissa;
+        value = (exponent < 0) ? (value / powersOfTen[-exponent]) : (value * powersOfTen[exponent]);
+        outValue = negative ? -value : value;
+
+        return true;
+    }
+
+    char buffer[64];
+    size_t length = end - begin;
+
+    if ((length == 0) || (length >= sizeof(buffer)))
+    {
+        return false;
+    }
+
+    memcpy(buffer, begin, length);
+    buffer[length] = '\0';
+
+    char *parsedEnd = NULL;
+    outValue = strtod(buffer, &parsedEnd);
+
+    return parsedEnd == buffer + length;
+}
+
+const char* PointCloudEngine::PlyReader::SkipWhitespace(const char *position, const char *end)
+{
+    // Commas and semicolons separate the columns of some exported files
+    while ((position < end) && ((*position == ' ') || (*position == '\t') || (*position == '\r') || (*position == ',') || (*position == ';')))
+    {
+        position++;
+    }
+
+    return position;
+}
+
+const char* PointCloudEngine::PlyReader::SkipToken(const char *position, const char *end)
+{
+    while ((position < end) && (*position != ' ') && (*position != '\t') && (*position != '\r') && (*position != ',') && (*position != ';'))
+    {
+        position++;
+    }
+
+    return position;
+}
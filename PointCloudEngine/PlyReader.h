@@ -0,0 +1,78 @@
+#ifndef PLYREADER_H
+#define PLYREADER_H
+
+#pragma once
+#include "PointCloudEngine.h"
+
+namespace PointCloudEngine
+{
+    // Reads the vertices of ply files directly from the memory mapped file
+    // Binary little endian and ascii ply files are supported, the vertex element has to be the first element and has to have all the position, normal and color properties
+    // Files with the extension .xyz or .pts are read as whitespace separated columns, their layout is detected from the amount of columns in the first line
+    // There are no intermediate buffers, each vertex is converted once from the mapped data into the output
+    class PlyReader
+    {
+    public:
+        // Maps the file and parses the header, check IsValid before reading the vertices
+        PlyReader(const std::wstring &plyfile);
+        ~PlyReader();
+
+        // False if the file could not be mapped or has another format, these files can still be loaded with tinyply
+        bool IsValid();
+
+        // Always 0 for column files, their vertex count is only known after reading them
+        size_t GetVertexCount();
+
+        // Size of the whole file in bytes
+        UINT64 GetFileSize();
+
+        // Converts the vertices in parallel with settings->buildThreadCount threads, the normals are normalized
+        // Text files are split into one chunk per thread at line boundaries, the lines of each chunk are counted first to know where its vertices start
+        // Text colors are converted like binary colors of their property type, column files have integer colors
+        // Column files without normals get zero normals and columns without colors get white
+        // The read bytes are added to the progress, returns false as soon as the progress is cancelled
+        bool ReadVertices(PointBuffer &outPoints, BuildProgress *progress = NULL);
+
+    private:
+        enum class Format
+        {
+            BinaryLittleEndian,
+            Ascii,
+            Columns
+        };
+
+        bool ParseHeader();
+        bool ParseColumnLayout();
+        bool ReadBinaryVertices(PointBuffer &outPoints, TaskScheduler &scheduler, BuildProgress *progress);
+        bool ReadTextVertices(PointBuffer &outPoints, TaskScheduler &scheduler, BuildProgress *progress);
+
+        // Text lines that contain a vertex, ascii ply lines are never empty and column files skip comments and lines with less than 3 columns (e.g. the point count of pts files)
+        bool IsVertexLine(const char *begin, const char *end);
+        bool ParseVertexLine(const char *begin, const char *end, PointBuffer &outPoints, const size_t &index);
+
+        // Parses a decimal number like std::from_chars, most numbers are converted exactly with one multiplication or division of doubles
+        // Other numbers (more than 19 digits, large exponents, inf, nan) fall back to strtod, returns false if the token is no number
+        static bool ParseNumber(const char *begin, const char *end, double &outValue);
+        static const char* SkipWhitespace(const char *position, const char *end);
+        static const char* SkipToken(const char *position, const char *end);
+
+        bool valid = false;
+        Format format = Format::BinaryLittleEndian;
+        UINT64 fileSize = 0;
+
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE mapping = NULL;
+        const byte *view = NULL;
+
+        // Layout of the vertex element, the properties are x, y, z, nx, ny, nz, red, green, blue
+        size_t vertexCount = 0;
+        size_t vertexStride = 0;
+        const byte *vertexData = NULL;
+        // The offsets are column indices in text files
+        PlyConverter::Property properties[9];
+
+        // Property index of each text column up to the last used one, -1 for unused columns
+        std::vector<int> columnProperties;
+    };
+}
+#endif
@@ -0,0 +1,179 @@
+#include "PlyStream.h"
+
+PointCloudEngine::PlyStream::PlyStream(const std::wstring &plyfile, const size_t &batchSize)
+{
+    this->plyfile = plyfile;
+    this->batchSize = max((size_t)1, batchSize);
+
+    valid = ReadHeader();
+}
+
+PointCloudEngine::PlyStream::~PlyStream()
+{
+    // Wake up the reading thread when it waits for a free buffer
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopped = true;
+    }
+
+    condition.notify_all();
+
+    if (readThread.joinable())
+    {
+        readThread.join();
+    }
+}
+
+bool PointCloudEngine::PlyStream::IsValid()
+{
+    return valid;
+}
+
+size_t PointCloudEngine::PlyStream::GetVertexCount()
+{
+    return vertexCount;
+}
+
+size_t PointCloudEngine::PlyStream::GetVertexStride()
+{
+    return vertexStride;
+}
+
+size_t PointCloudEngine::PlyStream::NextBatch(Vertex *outVertices, const size_t &maxCount)
+{
+    if (!valid || (maxCount == 0))
+    {
+        return 0;
+    }
+
+    if (!readThread.joinable())
+    {
+        buffers[0].data.resize(batchSize * vertexStride);
+        buffers[1].data.resize(batchSize * vertexStride);
+        readThread = std::thread(&PlyStream::ReadLoop, this);
+    }
+
+    StagingBuffer *buffer = &buffers[currentBuffer];
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        // Give a completely converted buffer back to the reading thread and continue with the other one
+        if (buffer->filled && (buffer->count > 0) && (currentOffset == buffer->count))
+        {
+            buffer->filled = false;
+            condition.notify_all();
+
+            currentBuffer = 1 - currentBuffer;
+            currentOffset = 0;
+            buffer = &buffers[currentBuffer];
+        }
+
+        condition.wait(lock, [&] { return buffer->filled; });
+    }
+
+    // The reading thread doesn't touch a filled buffer, convert it without holding the lock
+    size_t count = min(maxCount, buffer->count - currentOffset);
+    PlyConverter::Convert(buffer->data.data() + currentOffset * vertexStride, vertexStride, properties, count, outVertices);
+    currentOffset += count;
+
+    return count;
+}
+
+bool PointCloudEngine::PlyStream::Failed()
+{
+    return !valid || failed;
+}
+
+void PointCloudEngine::PlyStream::ReadLoop()
+{
+    std::ifstream file(plyfile, std::ios::binary);
+    file.seekg(dataStart);
+
+    size_t remainingCount = vertexCount;
+    int index = 0;
+
+    while (true)
+    {
+        StagingBuffer &buffer = buffers[index];
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [&] { return !buffer.filled || stopped; });
+
+            if (stopped)
+            {
+                return;
+            }
+        }
+
+        size_t count = min(batchSize, remainingCount);
+
+        if ((count > 0) && !file.read((char*)buffer.data.data(), count * vertexStride))
+        {
+            failed = true;
+            count = 0;
+        }
+
+        remainingCount -= count;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            buffer.count = count;
+            buffer.filled = true;
+        }
+
+        condition.notify_all();
+
+        if (count == 0)
+        {
+            return;
+        }
+
+        index = 1 - index;
+    }
+}
+
+bool PointCloudEngine::PlyStream::ReadHeader()
+{
+    std::ifstream file(plyfile, std::ios::binary);
+
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    // Collect the lines up to the end of the header with their line breaks, the offsets in the text are the offsets in the file
+    std::string text;
+    std::string line;
+
+    while (std::getline(file, line))
+    {
+        text += line + '\n';
+
+        // Stop early at files without a ply header
+        if (text.compare(0, 3, "ply") != 0)
+        {
+            return false;
+        }
+
+        if ((line == "end_header") || (line == "end_header\r"))
+        {
+            break;
+        }
+    }
+
+    PlyConverter::Header header;
+
+    if (!PlyConverter::ParseHeader(text.data(), text.size(), header) || (header.format != "binary_little_endian"))
+    {
+        return false;
+    }
+
+    vertexCount = header.vertexCount;
+    vertexStride = header.vertexStride;
+    dataStart = header.dataStart;
+    std::copy(header.properties, header.properties + 9, properties);
+
+    return true;
+}
@@ -0,0 +1,65 @@
+#ifndef PLYSTREAM_H
+#define PLYSTREAM_H
+
+#pragma once
+#include "PointCloudEngine.h"
+
+namespace PointCloudEngine
+{
+    // Reads the vertices of a binary little endian ply file in batches without loading the whole file
+    // A reading thread fills one of two staging buffers with raw ply data while the caller converts and processes the other one
+    // The memory use is the two staging buffers of batchSize vertices, independent of the file size
+    class PlyStream
+    {
+    public:
+        // Only parses the header, the reading thread is started with the first batch
+        PlyStream(const std::wstring &plyfile, const size_t &batchSize = 65536);
+        ~PlyStream();
+
+        // False if the file could not be opened or has another format, the vertex element has to be the first element and has to have all the position, normal and color properties
+        bool IsValid();
+        size_t GetVertexCount();
+
+        // Size of one vertex in the ply file in bytes
+        size_t GetVertexStride();
+
+        // Converts the next vertices into the output and returns their amount, at most maxCount and at most one staging buffer at once
+        // Returns 0 at the end of the file or when it could not be read, Failed tells the two apart
+        size_t NextBatch(Vertex *outVertices, const size_t &maxCount);
+        bool Failed();
+
+    private:
+        struct StagingBuffer
+        {
+            std::vector<byte> data;
+            size_t count = 0;
+            bool filled = false;
+        };
+
+        bool ReadHeader();
+        void ReadLoop();
+
+        std::wstring plyfile;
+        bool valid = false;
+        size_t batchSize = 0;
+
+        // Layout of the vertex element in the ply file
+        size_t vertexCount = 0;
+        size_t vertexStride = 0;
+        std::streamoff dataStart = 0;
+        PlyConverter::Property properties[9];
+
+        // The reading thread fills the buffers alternately, an empty filled buffer marks the end
+        std::thread readThread;
+        std::mutex mutex;
+        std::condition_variable condition;
+        StagingBuffer buffers[2];
+        std::atomic<bool> failed{ false };
+        bool stopped = false;
+
+        // Buffer that is converted by NextBatch and the amount of its vertices that are already converted
+        int currentBuffer = 0;
+        size_t currentOffset = 0;
+    };
+}
+#endif
@@ -0,0 +1,178 @@
+// SplatRenderer.h stores a PointBuffer by value, the engine header includes it after this class
+#include "PointCloudEngine.h"
+
+PointCloudEngine::PointBuffer::PointBuffer()
+{
+}
+
+PointCloudEngine::PointBuffer::PointBuffer(const PointBuffer &other)
+{
+    Resize(other.count);
+
+    std::copy(other.positions, other.positions + count, positions);
+    std::copy(other.normals, other.normals + count, normals);
+    std::copy(other.colors, other.colors + 3 * count, colors);
+}
+
+PointCloudEngine::PointBuffer::PointBuffer(PointBuffer &&other)
+{
+    std::swap(memory, other.memory);
+    std::swap(count, other.count);
+    std::swap(capacity, other.capacity);
+    std::swap(positions, other.positions);
+    std::swap(normals, other.normals);
+    std::swap(colors, other.colors);
+}
+
+PointCloudEngine::PointBuffer::~PointBuffer()
+{
+    _aligned_free(memory);
+}
+
+PointCloudEngine::PointBuffer& PointCloudEngine::PointBuffer::operator=(PointBuffer other)
+{
+    // The parameter is a copy or was moved from, swapping frees the old arrays with it
+    std::swap(memory, other.memory);
+    std::swap(count, other.count);
+    std::swap(capacity, other.capacity);
+    std::swap(positions, other.positions);
+    std::swap(normals, other.normals);
+    std::swap(colors, other.colors);
+
+    return *this;
+}
+
+void PointCloudEngine::PointBuffer::Resize(const size_t &count)
+{
+    if (count > capacity)
+    {
+        size_t vectorSize = AlignSize(count * sizeof(Vector3));
+        byte *newMemory = (byte*)_aligned_malloc(2 * vectorSize + AlignSize(3 * count), alignment);
+
+        if (newMemory == NULL)
+        {
+            throw std::bad_alloc();
+        }
+
+        Vector3 *newPositions = (Vector3*)newMemory;
+        Vector3 *newNormals = (Vector3*)(newMemory + vectorSize);
+        byte *newColors = newMemory + 2 * vectorSize;
+
+        std::copy(positions, positions + this->count, newPositions);
+        std::copy(normals, normals + this->count, newNormals);
+        std::copy(colors, colors + 3 * this->count, newColors);
+
+        _aligned_free(memory);
+
+        memory = newMemory;
+        capacity = count;
+        positions = newPositions;
+        normals = newNormals;
+        colors = newColors;
+    }
+
+    this->count = count;
+}
+
+void PointCloudEngine::PointBuffer::Clear()
+{
+    _aligned_free(memory);
+
+    memory = NULL;
+    count = 0;
+    capacity = 0;
+    positions = NULL;
+    normals = NULL;
+    colors = NULL;
+}
+
+size_t PointCloudEngine::PointBuffer::GetCount() const
+{
+    return count;
+}
+
+Vector3* PointCloudEngine::PointBuffer::GetPositions()
+{
+    return positions;
+}
+
+Vector3* PointCloudEngine::PointBuffer::GetNormals()
+{
+    return normals;
+}
+
+const Vector3* PointCloudEngine::PointBuffer::GetPositions() const
+{
+    return positions;
+}
+
+const Vector3* PointCloudEngine::PointBuffer::GetNormals() const
+{
+    return normals;
+}
+
+byte* PointCloudEngine::PointBuffer::GetColors()
+{
+    return colors;
+}
+
+const byte* PointCloudEngine::PointBuffer::GetColors() const
+{
+    return colors;
+}
+
+PointCloudEngine::Vertex PointCloudEngine::PointBuffer::GetVertex(const size_t &index) const
+{
+    Vertex vertex;
+    vertex.position = positions[index];
+    vertex.normal = normals[index];
+    std::copy(colors + 3 * index, colors + 3 * index + 3, vertex.color);
+
+    return vertex;
+}
+
+void PointCloudEngine::PointBuffer::SetVertex(const size_t &index, const Vertex &vertex)
+{
+    positions[index] = vertex.position;
+    normals[index] = vertex.normal;
+    std::copy(vertex.color, vertex.color + 3, colors + 3 * index);
+}
+
+void PointCloudEngine::PointBuffer::Interleave(const size_t &first, const size_t &count, Vertex *outVertices) const
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        outVertices[i] = GetVertex(first + i);
+    }
+}
+
+void PointCloudEngine::PointBuffer::Deinterleave(const size_t &first, const size_t &count, const Vertex *vertices)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        SetVertex(first + i, vertices[i]);
+    }
+}
+
+void PointCloudEngine::PointBuffer::GetBounds(Vector3 &outMin, Vector3 &outMax) const
+{
+    if (count == 0)
+    {
+        outMin = outMax = Vector3::Zero;
+        return;
+    }
+
+    // Only reads the position array
+    outMin = outMax = positions[0];
+
+    for (size_t i = 1; i < count; i++)
+    {
+        outMin = Vector3::Min(outMin, positions[i]);
+        outMax = Vector3::Max(outMax, positions[i]);
+    }
+}
+
+size_t PointCloudEngine::PointBuffer::AlignSize(const size_t &size)
+{
+    return (size + alignment - 1) & ~(alignment - 1);
+}
@@ -0,0 +1,62 @@
+#ifndef POINTBUFFER_H
+#define POINTBUFFER_H
+
+#pragma once
+#include "PointCloudEngine.h"
+
+namespace PointCloudEngine
+{
+    // Points of a cloud as separate position, normal and color arrays, each one starts at a cache line
+    // Passes that only need one of the attributes (bounds, morton codes, normal clustering) don't pull the others through the cache
+    // The vertex format is only created where it is needed, e.g. when uploading the vertex buffer or for the leaves of dynamic octrees
+    class PointBuffer
+    {
+    public:
+        PointBuffer();
+        PointBuffer(const PointBuffer &other);
+        PointBuffer(PointBuffer &&other);
+        ~PointBuffer();
+
+        PointBuffer& operator=(PointBuffer other);
+
+        // Keeps the points up to the new count, new points are uninitialized
+        // When this throws an std::bad_alloc exception, the memory requirement is large -> build with x64
+        void Resize(const size_t &count);
+        void Clear();
+        size_t GetCount() const;
+
+        Vector3* GetPositions();
+        Vector3* GetNormals();
+        const Vector3* GetPositions() const;
+        const Vector3* GetNormals() const;
+
+        // 3 bytes per point (red, green, blue)
+        byte* GetColors();
+        const byte* GetColors() const;
+
+        Vertex GetVertex(const size_t &index) const;
+        void SetVertex(const size_t &index, const Vertex &vertex);
+
+        // Converts between the arrays and the vertex format for the given range of points
+        void Interleave(const size_t &first, const size_t &count, Vertex *outVertices) const;
+        void Deinterleave(const size_t &first, const size_t &count, const Vertex *vertices);
+
+        // Minimum and maximum position, both are zero for an empty buffer
+        void GetBounds(Vector3 &outMin, Vector3 &outMax) const;
+
+    private:
+        static const size_t alignment = 64;
+
+        // One allocation for all 3 arrays, the normals and colors start at aligned offsets after the positions
+        byte *memory = NULL;
+        size_t count = 0;
+        size_t capacity = 0;
+
+        Vector3 *positions = NULL;
+        Vector3 *normals = NULL;
+        byte *colors = NULL;
+
+        static size_t AlignSize(const size_t &size);
+    };
+}
+#endif
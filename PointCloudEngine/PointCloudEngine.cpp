@@ -52,12 +52,108 @@ void SafeRelease(ID3D11Resource *resource)
     }
 }
 
-bool LoadPlyFile(std::vector<Vertex> &vertices, std::wstring plyfile)
+bool LoadPlyFile(PointBuffer &points, std::wstring plyfile, BuildProgress *progress)
+{
+    // Binary little endian, ascii and .xyz/.pts files are converted directly from the memory mapped file
+    PlyReader reader(plyfile);
+
+    if (reader.IsValid())
+    {
+        try
+        {
+            return reader.ReadVertices(points, progress) && (points.GetCount() > 0);
+        }
+        catch (const std::exception &e)
+        {
+            return false;
+        }
+    }
+
+    return LoadPlyFileWithTinyply(points, plyfile, progress);
+}
+
+// Reads the file for tinyply in blocks, counts the read bytes and ends the stream as soon as the progress is cancelled
+class ProgressStreamBuffer : public std::streambuf
+{
+public:
+    ProgressStreamBuffer(std::streambuf *source, BuildProgress *progress) : source(source), progress(progress), buffer(1024 * 1024)
+    {
+        setg(buffer.data(), buffer.data(), buffer.data());
+    }
+
+protected:
+    int_type underflow() override
+    {
+        if (gptr() < egptr())
+        {
+            return traits_type::to_int_type(*gptr());
+        }
+
+        if ((progress != NULL) && progress->cancelled)
+        {
+            return traits_type::eof();
+        }
+
+        std::streamsize count = source->sgetn(buffer.data(), buffer.size());
+
+        if (count <= 0)
+        {
+            return traits_type::eof();
+        }
+
+        if (progress != NULL)
+        {
+            progress->readByteCount += count;
+        }
+
+        setg(buffer.data(), buffer.data(), buffer.data() + count);
+
+        return traits_type::to_int_type(*gptr());
+    }
+
+    pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode mode) override
+    {
+        // The source is ahead of this stream by the bytes that are still buffered
+        if (direction == std::ios_base::cur)
+        {
+            offset -= egptr() - gptr();
+        }
+
+        setg(buffer.data(), buffer.data(), buffer.data());
+
+        return source->pubseekoff(offset, direction, mode);
+    }
+
+    pos_type seekpos(pos_type position, std::ios_base::openmode mode) override
+    {
+        setg(buffer.data(), buffer.data(), buffer.data());
+
+        return source->pubseekpos(position, mode);
+    }
+
+private:
+    std::streambuf *source = NULL;
+    BuildProgress *progress = NULL;
+    std::vector<char> buffer;
+};
+
+bool LoadPlyFileWithTinyply(PointBuffer &points, std::wstring plyfile, BuildProgress *progress)
 {
     try
     {
         // Load ply file
-        std::ifstream ss(plyfile, std::ios::binary);
+        std::ifstream fileStream(plyfile, std::ios::binary | std::ios::ate);
+
+        // Tinyply reads the data twice, the first pass calculates the sizes of the lists
+        if (progress != NULL)
+        {
+            progress->readByteCount = 0;
+            progress->fileByteCount = 2 * (UINT64)max((std::streamoff)0, (std::streamoff)fileStream.tellg());
+        }
+
+        fileStream.seekg(0);
+        ProgressStreamBuffer streamBuffer(fileStream.rdbuf(), progress);
+        std::istream ss(&streamBuffer);
 
         tinyply::PlyFile file;
         file.parse_header(ss);
@@ -70,28 +166,35 @@ bool LoadPlyFile(std::vector<Vertex> &vertices, std::wstring plyfile)
         rawNormals = file.request_properties_from_element("vertex", { "nx", "ny", "nz" });
         rawColors = file.request_properties_from_element("vertex", { "red", "green", "blue" });
 
-        // Read the file
+        // Read the file, a cancelled read ends the stream early and leaves the buffers incomplete
         file.read(ss);
 
-        // Create vertices
-        size_t count = rawPositions->count;
-        size_t stridePositions = rawPositions->buffer.size_bytes() / count;
-        size_t strideNormals = rawNormals->buffer.size_bytes() / count;
-        size_t strideColors = rawColors->buffer.size_bytes() / count;
+        if ((progress != NULL) && progress->cancelled)
+        {
+            return false;
+        }
 
-        // When this trows an std::bad_alloc exception, the memory requirement is large -> build with x64
-        vertices = std::vector<Vertex>(count);
+        // Tinyply stores the 3 properties of each attribute consecutively in one buffer with the type of the file
+        PlyConverter::Source sources[3];
+        std::shared_ptr<tinyply::PlyData> rawData[3] = { rawPositions, rawNormals, rawColors };
 
-        // Fill each vertex with its data
-        for (int i = 0; i < count; i++)
+        for (int i = 0; i < 3; i++)
         {
-            std::memcpy(&vertices[i].position, rawPositions->buffer.get() + i * stridePositions, stridePositions);
-            std::memcpy(&vertices[i].normal, rawNormals->buffer.get() + i * strideNormals, strideNormals);
-            std::memcpy(&vertices[i].color, rawColors->buffer.get() + i * strideColors, strideColors);
+            int propertyStride = tinyply::PropertyTable[rawData[i]->t].stride;
 
-            // Make sure that the normals are normalized
-            vertices[i].normal.Normalize();
+            sources[i].data = rawData[i]->buffer.get();
+            sources[i].stride = 3 * propertyStride;
+
+            for (int j = 0; j < 3; j++)
+            {
+                sources[i].properties[j].offset = j * propertyStride;
+                sources[i].properties[j].type = rawData[i]->t;
+            }
         }
+
+        // When this trows an std::bad_alloc exception, the memory requirement is large -> build with x64
+        points.Resize(rawPositions->count);
+        PlyConverter::Convert(sources[0], sources[1], sources[2], points.GetCount(), points, 0);
     }
     catch (const std::exception &e)
     {
@@ -112,6 +215,22 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
     // Load the settings
     settings = new Settings();
 
+    // Only run the benchmarks without creating a window when started with -benchmark
+    if (strstr(lpCmdLine, "-benchmark") != NULL)
+    {
+        Benchmark::Run(settings->plyfile);
+        SafeDelete(settings);
+        return 0;
+    }
+
+    // Check that the octree build is deterministic without creating a window, the exit code is 1 if any hash differs
+    if (strstr(lpCmdLine, "-determinism") != NULL)
+    {
+        bool passed = Benchmark::Determinism();
+        SafeDelete(settings);
+        return passed ? 0 : 1;
+    }
+
 	if (!InitializeWindow(hInstance, nShowCmd, settings->resolutionX, settings->resolutionY, true))
 	{
         ErrorMessage(L"Window Initialization failed.", L"WinMain", __FILEW__, __LINE__);
@@ -17,8 +17,19 @@
 #include <algorithm>
 #include <limits>
 #include <map>
+#include <set>
 #include <queue>
 #include <math.h>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <random>
+#include <intrin.h>
+#include <immintrin.h>
 
 // Tinyply
 #include "tinyply.h"
@@ -58,6 +69,21 @@ namespace PointCloudEngine
     class Camera;
     class OctreeNode;
     class Octree;
+    class TaskScheduler;
+    struct TaskGroup;
+    class MemoryArena;
+    class MortonCode;
+    class ViewFrustum;
+    class KMeans;
+    class NormalCodec;
+    class ColorCodec;
+    class PointBuffer;
+    class PlyConverter;
+    class PlyReader;
+    class PlyStream;
+    class OutOfCoreBuilder;
+    class OctreeCache;
+    class Benchmark;
 }
 
 using namespace PointCloudEngine;
@@ -72,13 +98,27 @@ using namespace PointCloudEngine;
 #include "Hierarchy.h"
 #include "DataStructures.h"
 #include "Settings.h"
+#include "TaskScheduler.h"
+#include "MemoryArena.h"
+#include "MortonCode.h"
+#include "ViewFrustum.h"
+#include "KMeans.h"
+#include "NormalCodec.h"
+#include "ColorCodec.h"
+#include "PointBuffer.h"
+#include "PlyConverter.h"
+#include "PlyReader.h"
+#include "PlyStream.h"
 #include "IRenderer.h"
 #include "OctreeNode.h"
+#include "OctreeCache.h"
 #include "Octree.h"
+#include "OutOfCoreBuilder.h"
 #include "TextRenderer.h"
 #include "SplatRenderer.h"
 #include "OctreeRenderer.h"
 #include "Scene.h"
+#include "Benchmark.h"
 
 // Global variables, accessable in other files
 extern std::wstring executablePath;
@@ -100,7 +140,8 @@ extern ID3D11DepthStencilState* depthStencilState;
 // Global function declarations
 extern void ErrorMessage(std::wstring message, std::wstring header, std::wstring file, int line, HRESULT hr = E_FAIL);
 extern void SafeRelease(ID3D11Resource *resource);
-extern bool LoadPlyFile(std::vector<Vertex> &vertices, std::wstring plyfile);
+extern bool LoadPlyFile(PointBuffer &points, std::wstring plyfile, BuildProgress *progress = NULL);
+extern bool LoadPlyFileWithTinyply(PointBuffer &points, std::wstring plyfile, BuildProgress *progress = NULL);
 
 // Function declarations
 bool InitializeWindow(HINSTANCE hInstancem, int ShowWnd, int width, int hight, bool windowed);
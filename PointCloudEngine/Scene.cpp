@@ -6,7 +6,7 @@ void Scene::Initialize()
     pointCloud = Hierarchy::Create(L"PointCloud");
 
     // Create loading text and hide it
-    TextRenderer *loadingTextRenderer = new TextRenderer(TextRenderer::GetSpriteFont(L"Consolas"), false);
+    loadingTextRenderer = new TextRenderer(TextRenderer::GetSpriteFont(L"Consolas"), false);
     loadingTextRenderer->text = L"Loading...";
     loadingText = Hierarchy::Create(L"Loading Text");
     loadingText->AddComponent(loadingTextRenderer);
@@ -23,7 +23,7 @@ void Scene::Initialize()
     text->transform->scale = 0.35f * Vector3::One;
 
     // Try to load the last plyfile
-    DelayedLoadFile(settings->plyfile);
+    LoadFile(settings->plyfile);
 }
 
 void Scene::Update(Timer &timer)
@@ -100,7 +100,7 @@ void Scene::Update(Timer &timer)
     if (help)
     {
         textRenderer->text.append(L"[H] Toggle help\n");
-        textRenderer->text.append(L"[O] Open .ply file with (x,y,z,nx,ny,nz,red,green,blue) format\n");
+        textRenderer->text.append(L"[O] Open .ply file with (x,y,z,nx,ny,nz,red,green,blue) format or .xyz/.pts file\n");
         textRenderer->text.append(L"[WASD] Move Camera\n");
         textRenderer->text.append(L"[MOUSE] Rotate Camera\n");
         textRenderer->text.append(L"[MOUSE WHEEL] Scale\n");
@@ -115,17 +115,31 @@ void Scene::Update(Timer &timer)
         textRenderer->text.append(L"Press [H] to show help");
     }
 
-    // Check if there is a file that should be loaded delayed
-    if (timeUntilLoadFile > 0)
+    // Swap in the new point cloud once the background loading is finished
+    if (loadThread.joinable())
     {
-        timeUntilLoadFile -= dt;
-
-        if (timeUntilLoadFile < 0)
+        if (loadFinished)
+        {
+            FinishLoadFile();
+        }
+        else
         {
-            LoadFile();
+            UINT64 vertexCount = loadProgress->vertexCount;
+            UINT64 fileByteCount = loadProgress->fileByteCount;
+            loadingTextRenderer->text = L"Loading...";
+
+            if (vertexCount > 0)
+            {
+                loadingTextRenderer->text.append(L" " + std::to_wstring((100 * loadProgress->processedVertexCount) / vertexCount) + L"%");
+            }
+            else if (fileByteCount > 0)
+            {
+                loadingTextRenderer->text = L"Reading... " + std::to_wstring((100 * min(loadProgress->readByteCount.load(), fileByteCount)) / fileByteCount) + L"%";
+            }
         }
     }
-    else if (Input::GetKeyDown(Keyboard::O))
+
+    if (Input::GetKeyDown(Keyboard::O))
     {
         // Open file dialog to load another file
         wchar_t filename[MAX_PATH];
@@ -133,7 +147,7 @@ void Scene::Update(Timer &timer)
         ZeroMemory(&openFileName, sizeof(OPENFILENAMEW));
         openFileName.lStructSize = sizeof(OPENFILENAMEW);
         openFileName.hwndOwner = hwnd;
-        openFileName.lpstrFilter = L"Ply Files\0*.ply\0\0";
+        openFileName.lpstrFilter = L"Point Cloud Files\0*.ply;*.xyz;*.pts\0\0";
         openFileName.lpstrFile = filename;
         openFileName.lpstrFile[0] = L'\0';
         openFileName.nMaxFile = MAX_PATH;
@@ -145,7 +159,7 @@ void Scene::Update(Timer &timer)
 
         if (GetOpenFileNameW(&openFileName))
         {
-            DelayedLoadFile(filename);
+            LoadFile(filename);
         }
 
         Input::SetMode(Mouse::MODE_RELATIVE);
@@ -167,73 +181,143 @@ void Scene::Draw()
 
 void Scene::Release()
 {
+    CancelLoadFile();
     Hierarchy::ReleaseAllSceneObjects();
 }
 
-void PointCloudEngine::Scene::DelayedLoadFile(std::wstring filepath)
+void PointCloudEngine::Scene::LoadFile(std::wstring filepath)
 {
     std::wifstream file(filepath);
 
     // Check if the file exists
     if (file.is_open())
     {
-        // Load after some delay
-        timeUntilLoadFile = 0.1f;
-        settings->plyfile = filepath;
+        // Opening another file cancels the file that is still loading
+        CancelLoadFile();
+
+        loadFilepath = filepath;
+        loadProgress = new BuildProgress();
+        loadFinished = false;
+        loadThread = std::thread(&Scene::LoadFileInBackground, this);
 
         // Show huge loading text
+        loadingTextRenderer->text = L"Loading...";
         loadingText->transform->scale = 1.5f * Vector3::One;
     }
 }
 
-void PointCloudEngine::Scene::LoadFile()
+void PointCloudEngine::Scene::LoadFileInBackground()
 {
-    // Release resources before loading
-    if (pointCloudRenderer != NULL)
+    // A valid cache is memory mapped instead of loading the vertices and building the octree again
+    // Dynamic octrees need the vertices of the leaves and are never cached, the splat renderer cannot draw caches
+    if (!settings->dynamicOctree && std::is_same<RENDERER, OctreeRenderer>::value)
     {
-        pointCloud->RemoveComponent(pointCloudRenderer);
+        OctreeCache *cache = new OctreeCache(loadFilepath, settings->maxOctreeDepth);
+
+        if (cache->IsValid())
+        {
+            loadVertexCount = cache->GetVertexCount();
+            loadedRenderer = new RENDERER(cache);
+            loadFinished = true;
+            return;
+        }
+
+        SafeDelete(cache);
     }
 
-    std::vector<Vertex> vertices;
+    PointBuffer points;
 
-    // Try to load the file
-    if (LoadPlyFile(vertices, settings->plyfile))
-    {
-        size_t vertexCount = vertices.size();
-        SetWindowTextW(hwnd, (std::to_wstring(vertexCount) + L" Points at " + settings->plyfile + L" - PointCloudEngine ").c_str());
+    // Clouds whose in-core build doesn't fit into the memory budget are built out-of-core without loading them
+    size_t plyVertexCount = OutOfCoreBuilder::GetVertexCount(loadFilepath);
 
-        // Build the octree from the points (takes a long time)
-        pointCloudRenderer = new RENDERER(vertices);
-        pointCloud->AddComponent(pointCloudRenderer);
+    if (Octree::GetBuildMemorySize(plyVertexCount) > (UINT64)settings->outOfCoreMemoryBudget * 1024 * 1024)
+    {
+        loadVertexCount = plyVertexCount;
+        loadedRenderer = new RENDERER(loadFilepath, loadProgress);
     }
-    else
+    else if (LoadPlyFile(points, loadFilepath, loadProgress) && !loadProgress->cancelled)
     {
-        ErrorMessage(L"Could not open " + settings->plyfile + L"\nOnly .ply files with x,y,z,nx,ny,nz,red,green,blue vertex format are supported!", L"File loading error", __FILEW__, __LINE__);
+        // Build the octree from the points (takes a long time), the renderer takes over the points
+        loadVertexCount = points.GetCount();
+        loadedRenderer = new RENDERER(std::move(points), loadProgress);
     }
 
-    // Hide loading text
-    loadingText->transform->scale = Vector3::Zero;
-    timeSinceLoadFile = 0;
+    // A cancelled build is incomplete and must not be cached
+    if ((loadedRenderer != NULL) && !loadProgress->cancelled)
+    {
+        loadedRenderer->WriteCache(loadFilepath, loadVertexCount);
+    }
 
-    // Reset point cloud
-    pointCloud->transform->position = Vector3::Zero;
-    pointCloud->transform->rotation = Quaternion::Identity;
+    loadFinished = true;
+}
 
-    // Set camera position in front of the object
-    if (pointCloudRenderer != NULL)
+void PointCloudEngine::Scene::FinishLoadFile()
+{
+    loadThread.join();
+
+    if (loadedRenderer != NULL)
     {
+        // Swap the renderers within one frame, the resources of the new renderer are created when it is initialized in the next update
+        if (pointCloudRenderer != NULL)
+        {
+            pointCloud->RemoveComponent(pointCloudRenderer);
+        }
+
+        pointCloudRenderer = loadedRenderer;
+        loadedRenderer = NULL;
+        pointCloud->AddComponent(pointCloudRenderer);
+
+        settings->plyfile = loadFilepath;
+        SetWindowTextW(hwnd, (std::to_wstring(loadVertexCount) + L" Points at " + settings->plyfile + L" - PointCloudEngine ").c_str());
+
+        timeSinceLoadFile = 0;
+
+        // Reset point cloud
+        pointCloud->transform->position = Vector3::Zero;
+        pointCloud->transform->rotation = Quaternion::Identity;
+
+        // Set camera position in front of the object
         Vector3 boundingBoxPosition;
         float boundingBoxSize;
 
         pointCloudRenderer->GetBoundingCubePositionAndSize(boundingBoxPosition, boundingBoxSize);
 
         camera->SetPosition(settings->scale * (boundingBoxPosition - boundingBoxSize * Vector3::UnitZ));
+
+        // Reset camera rotation
+        cameraPitch = 0;
+        cameraYaw = 0;
+
+        // Reset other properties
+        splatSize = 0.01f;
+    }
+    else
+    {
+        ErrorMessage(L"Could not open " + loadFilepath + L"\nOnly .ply files with x,y,z,nx,ny,nz,red,green,blue vertex format and .xyz/.pts files with x,y,z columns are supported!", L"File loading error", __FILEW__, __LINE__);
     }
 
-    // Reset camera rotation
-    cameraPitch = 0;
-    cameraYaw = 0;
+    SafeDelete(loadProgress);
 
-    // Reset other properties
-    splatSize = 0.01f;
+    // Hide loading text
+    loadingText->transform->scale = Vector3::Zero;
+}
+
+void PointCloudEngine::Scene::CancelLoadFile()
+{
+    if (loadThread.joinable())
+    {
+        // Waits until the reading or the build notices the cancellation
+        loadProgress->cancelled = true;
+        loadThread.join();
+    }
+
+    // The renderer of a cancelled build is incomplete and was never initialized
+    if (loadedRenderer != NULL)
+    {
+        loadedRenderer->Release();
+        SafeDelete(loadedRenderer);
+    }
+
+    SafeDelete(loadProgress);
+    loadingText->transform->scale = Vector3::Zero;
 }
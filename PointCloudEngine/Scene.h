@@ -17,15 +17,28 @@ namespace PointCloudEngine
         void Release();
 
     private:
-        void DelayedLoadFile(std::wstring filepath);
-        void LoadFile();
+        // Loads the file and builds its renderer on a background thread, a file that is still loading is cancelled
+        // The current point cloud is rendered until the new renderer is swapped in by FinishLoadFile
+        void LoadFile(std::wstring filepath);
+        void LoadFileInBackground();
+        void FinishLoadFile();
+        void CancelLoadFile();
 
         SceneObject *text = NULL;
         SceneObject *loadingText = NULL;
         SceneObject *pointCloud = NULL;
         TextRenderer *textRenderer = NULL;
+        TextRenderer *loadingTextRenderer = NULL;
         RENDERER *pointCloudRenderer = NULL;
 
+        // Only the background thread writes the loaded renderer and vertex count until loadFinished is set
+        std::thread loadThread;
+        std::atomic<bool> loadFinished{ false };
+        BuildProgress *loadProgress = NULL;
+        std::wstring loadFilepath;
+        size_t loadVertexCount = 0;
+        RENDERER *loadedRenderer = NULL;
+
         Vector2 input;
         bool help = false;
         bool rotate = false;
@@ -34,7 +47,6 @@ namespace PointCloudEngine
         float cameraYaw = 0;
         float cameraSpeed = 0;
 
-        float timeUntilLoadFile = -1.0f;
         float timeSinceLoadFile = 0.0f;
     };
 }
@@ -65,6 +65,62 @@ PointCloudEngine::Settings::Settings()
                 {
                     scale = std::stof(variableValue);
                 }
+                else if (variableName.compare(NAMEOF(octreeBuilder)) == 0)
+                {
+                    octreeBuilder = (OctreeBuilder)std::stoi(variableValue);
+                }
+                else if (variableName.compare(NAMEOF(buildThreadCount)) == 0)
+                {
+                    buildThreadCount = std::stoi(variableValue);
+                }
+                else if (variableName.compare(NAMEOF(parallelBuildCutoff)) == 0)
+                {
+                    parallelBuildCutoff = std::stoi(variableValue);
+                }
+                else if (variableName.compare(NAMEOF(subdivisionMode)) == 0)
+                {
+                    subdivisionMode = (SubdivisionMode)std::stoi(variableValue);
+                }
+                else if (variableName.compare(NAMEOF(maxLeafVertexCount)) == 0)
+                {
+                    maxLeafVertexCount = std::stoi(variableValue);
+                }
+                else if (variableName.compare(NAMEOF(minNodeSize)) == 0)
+                {
+                    minNodeSize = std::stof(variableValue);
+                }
+                else if (variableName.compare(NAMEOF(clusteringMode)) == 0)
+                {
+                    clusteringMode = (ClusteringMode)std::stoi(variableValue);
+                }
+                else if (variableName.compare(NAMEOF(kMeansMaxIterations)) == 0)
+                {
+                    kMeansMaxIterations = std::stoi(variableValue);
+                }
+                else if (variableName.compare(NAMEOF(kMeansTolerance)) == 0)
+                {
+                    kMeansTolerance = std::stof(variableValue);
+                }
+                else if (variableName.compare(NAMEOF(outOfCoreMemoryBudget)) == 0)
+                {
+                    outOfCoreMemoryBudget = std::stoi(variableValue);
+                }
+                else if (variableName.compare(NAMEOF(outOfCoreDirectory)) == 0)
+                {
+                    outOfCoreDirectory = variableValue;
+                }
+                else if (variableName.compare(NAMEOF(dynamicOctree)) == 0)
+                {
+                    dynamicOctree = std::stoi(variableValue);
+                }
+                else if (variableName.compare(NAMEOF(octreePageBudget)) == 0)
+                {
+                    octreePageBudget = std::stoi(variableValue);
+                }
+                else if (variableName.compare(NAMEOF(colorFormat)) == 0)
+                {
+                    colorFormat = (ColorFormat)std::stoi(variableValue);
+                }
                 else if (variableName.compare(NAMEOF(mouseSensitivity)) == 0)
                 {
                     mouseSensitivity = std::stof(variableValue);
@@ -102,6 +158,28 @@ PointCloudEngine::Settings::~Settings()
     settingsFile << NAMEOF(scale) << L"=" << scale << std::endl;
     settingsFile << std::endl;
 
+    settingsFile << L"# Octree Build Parameters" << std::endl;
+    settingsFile << L"# 0: Top down, 1: Morton code sort" << std::endl;
+    settingsFile << NAMEOF(octreeBuilder) << L"=" << (int)octreeBuilder << std::endl;
+    settingsFile << NAMEOF(buildThreadCount) << L"=" << buildThreadCount << std::endl;
+    settingsFile << NAMEOF(parallelBuildCutoff) << L"=" << parallelBuildCutoff << std::endl;
+    settingsFile << L"# 0: Subdivide until maxOctreeDepth, 1: Subdivide nodes with more than maxLeafVertexCount vertices that are larger than minNodeSize" << std::endl;
+    settingsFile << NAMEOF(subdivisionMode) << L"=" << (int)subdivisionMode << std::endl;
+    settingsFile << NAMEOF(maxLeafVertexCount) << L"=" << maxLeafVertexCount << std::endl;
+    settingsFile << NAMEOF(minNodeSize) << L"=" << minNodeSize << std::endl;
+    settingsFile << L"# 0: K-means in every node, 1: Merge the child clusters bottom up" << std::endl;
+    settingsFile << NAMEOF(clusteringMode) << L"=" << (int)clusteringMode << std::endl;
+    settingsFile << NAMEOF(kMeansMaxIterations) << L"=" << kMeansMaxIterations << std::endl;
+    settingsFile << NAMEOF(kMeansTolerance) << L"=" << kMeansTolerance << std::endl;
+    settingsFile << NAMEOF(outOfCoreMemoryBudget) << L"=" << outOfCoreMemoryBudget << std::endl;
+    settingsFile << L"# Empty: Temporary folder of the system, out-of-core builds of large clouds write about as much data as the ply file there" << std::endl;
+    settingsFile << NAMEOF(outOfCoreDirectory) << L"=" << outOfCoreDirectory << std::endl;
+    settingsFile << NAMEOF(dynamicOctree) << L"=" << dynamicOctree << std::endl;
+    settingsFile << NAMEOF(octreePageBudget) << L"=" << octreePageBudget << std::endl;
+    settingsFile << L"# 0: 6-6-4 bit RGB, 1: 5-6-5 bit RGB, 2: 6-5-5 bit YCoCg" << std::endl;
+    settingsFile << NAMEOF(colorFormat) << L"=" << (int)colorFormat << std::endl;
+    settingsFile << std::endl;
+
     settingsFile << L"# Input Parameters" << std::endl;
     settingsFile << NAMEOF(mouseSensitivity) << L"=" << mouseSensitivity << std::endl;
     settingsFile << NAMEOF(scrollSensitivity) << L"=" << scrollSensitivity << std::endl;
@@ -25,9 +25,25 @@ namespace PointCloudEngine
 
         // Ply file parameters default values
         std::wstring plyfile = L"";
-        int maxOctreeDepth = 12;
+        int maxOctreeDepth = 12;                // Safety cap in the adaptive subdivision mode
         float scale = 1.0f;
 
+        // Octree build parameters default values
+        OctreeBuilder octreeBuilder = OctreeBuilder::TopDown;
+        int buildThreadCount = 0;               // 0 uses all hardware threads
+        int parallelBuildCutoff = 100000;       // Subtrees with less vertices are built sequentially
+        SubdivisionMode subdivisionMode = SubdivisionMode::FixedDepth;
+        int maxLeafVertexCount = 64;            // Adaptive nodes with at most this many vertices are leaves
+        float minNodeSize = 0.0f;               // Adaptive nodes that are this small or smaller are leaves
+        ClusteringMode clusteringMode = ClusteringMode::PerNode;
+        int kMeansMaxIterations = 30;           // Upper limit for the normal clustering iterations of each node
+        float kMeansTolerance = 0.001f;         // Clustering stops when no mean moves further than this
+        int outOfCoreMemoryBudget = 4096;       // Megabytes that a build may use, clouds whose in-core build needs more are built out-of-core from the file
+        std::wstring outOfCoreDirectory = L"";  // Folder for the temporary files of out-of-core builds, empty uses the temporary folder of the system
+        bool dynamicOctree = false;             // Keeps the leaf vertices to allow inserting and removing vertices after the build
+        int octreePageBudget = 1024;            // Megabytes of cached octree nodes in memory, larger caches are streamed in pages
+        ColorFormat colorFormat = ColorFormat::RGB565;
+
         // Input parameters default values
         float mouseSensitivity = 0.5f;
         float scrollSensitivity = 0.5f;
@@ -1,16 +1,31 @@
 #include "SplatRenderer.h"
 
-SplatRenderer::SplatRenderer(const std::vector<Vertex> &vertices)
+SplatRenderer::SplatRenderer(PointBuffer points, BuildProgress *progress)
 {
-    this->vertices = vertices;
+    this->points = std::move(points);
 
     // Set the default values
     constantBufferData.splatSize = 0.01f;
     constantBufferData.fovAngleY = settings->fovAngleY;
 }
 
+SplatRenderer::SplatRenderer(const std::wstring &plyfile, BuildProgress *progress) : SplatRenderer(PointBuffer())
+{
+    LoadPlyFile(points, plyfile, progress);
+}
+
+SplatRenderer::SplatRenderer(OctreeCache *cache) : SplatRenderer(PointBuffer())
+{
+    SafeDelete(cache);
+    ErrorMessage(L"The splat renderer cannot draw an octree cache", L"SplatRenderer", __FILEW__, __LINE__);
+}
+
 void SplatRenderer::Initialize(SceneObject *sceneObject)
 {
+    // Interleave the points into the vertex format of the input layout, the vertices are freed after the upload
+    std::vector<Vertex> vertices(points.GetCount());
+    points.Interleave(0, vertices.size(), vertices.data());
+
     // Create a vertex buffer description
     D3D11_BUFFER_DESC vertexBufferDesc;
     ZeroMemory(&vertexBufferDesc, sizeof(vertexBufferDesc));
@@ -77,7 +92,7 @@ void SplatRenderer::Draw(SceneObject *sceneObject)
     d3d11DevCon->VSSetConstantBuffers(0, 1, &constantBuffer);
     d3d11DevCon->GSSetConstantBuffers(0, 1, &constantBuffer);
 
-    d3d11DevCon->Draw(vertices.size(), 0);
+    d3d11DevCon->Draw(points.GetCount(), 0);
 }
 
 void SplatRenderer::Release()
@@ -96,3 +111,8 @@ void PointCloudEngine::SplatRenderer::GetBoundingCubePositionAndSize(Vector3 &ou
     outPosition = Vector3::Zero;
     outSize = settings->scale;
 }
+
+bool PointCloudEngine::SplatRenderer::WriteCache(const std::wstring &plyfile, const UINT64 &vertexCount)
+{
+    return false;
+}
@@ -9,7 +9,15 @@ namespace PointCloudEngine
     class SplatRenderer : public Component, public IRenderer
     {
     public:
-        SplatRenderer(const std::vector<Vertex> &vertices);
+        // Same constructors as the octree renderer so that the scene can use either of them, there is no build and the progress is ignored
+        SplatRenderer(PointBuffer points, BuildProgress *progress = NULL);
+
+        // All the splats are uploaded at once, clouds that the octree renderer would build out-of-core are loaded completely
+        SplatRenderer(const std::wstring &plyfile, BuildProgress *progress = NULL);
+
+        // Caches only contain octree nodes and are not supported, the cache is deleted and nothing is drawn
+        SplatRenderer(OctreeCache *cache);
+
         void Initialize(SceneObject *sceneObject);
         void Update(SceneObject *sceneObject);
         void Draw(SceneObject *sceneObject);
@@ -18,6 +26,9 @@ namespace PointCloudEngine
         void SetSplatSize(const float &splatSize);
         void GetBoundingCubePositionAndSize(Vector3 &outPosition, float &outSize);
 
+        // There is no octree to cache, always returns false
+        bool WriteCache(const std::wstring &plyfile, const UINT64 &vertexCount);
+
     private:
         // Same constant buffer as in effect file, keep packing rules in mind
         struct SplatRendererConstantBuffer
@@ -32,7 +43,8 @@ namespace PointCloudEngine
             float padding[3];
         };
 
-        std::vector<Vertex> vertices;
+        // The vertex format is only created for the upload
+        PointBuffer points;
         SplatRendererConstantBuffer constantBufferData;
 
         // Vertex buffer
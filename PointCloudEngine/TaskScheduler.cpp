@@ -0,0 +1,185 @@
+#include "TaskScheduler.h"
+
+// Used to find the queue of the calling thread, threads that don't belong to the scheduler use the queue of worker 0
+static thread_local TaskScheduler *currentScheduler = NULL;
+static thread_local int currentWorkerIndex = 0;
+
+PointCloudEngine::TaskScheduler::TaskScheduler(const int &threadCount)
+{
+    this->threadCount = (threadCount > 0) ? threadCount : max(1, (int)std::thread::hardware_concurrency());
+
+    for (int i = 0; i < this->threadCount; i++)
+    {
+        queues.push_back(new TaskQueue());
+    }
+
+    // The creating thread is worker 0, start the other workers
+    currentScheduler = this;
+    currentWorkerIndex = 0;
+
+    for (int i = 1; i < this->threadCount; i++)
+    {
+        threads.push_back(std::thread(&TaskScheduler::WorkerLoop, this, i));
+    }
+}
+
+PointCloudEngine::TaskScheduler::~TaskScheduler()
+{
+    // Wake up all the sleeping workers and wait until they are finished
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        running = false;
+    }
+
+    sleepCondition.notify_all();
+
+    for (auto it = threads.begin(); it != threads.end(); it++)
+    {
+        it->join();
+    }
+
+    for (auto it = queues.begin(); it != queues.end(); it++)
+    {
+        SafeDelete(*it);
+    }
+
+    if (currentScheduler == this)
+    {
+        currentScheduler = NULL;
+    }
+}
+
+void PointCloudEngine::TaskScheduler::Spawn(TaskGroup &group, std::function<void()> task)
+{
+    group.pendingTasks++;
+
+    // Push the task to the back of the queue of the calling worker
+    TaskQueue *queue = queues[GetWorkerIndex()];
+
+    {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        queue->tasks.push_back({ &group, task });
+    }
+
+    // Lock the mutex before notifying to make sure that a worker that is about to sleep doesn't miss this task
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        queuedTasks++;
+    }
+
+    sleepCondition.notify_one();
+}
+
+void PointCloudEngine::TaskScheduler::Wait(TaskGroup &group)
+{
+    int workerIndex = GetWorkerIndex();
+
+    // Execute other tasks instead of blocking, this also prevents deadlocks when tasks wait for their own child tasks
+    while (group.pendingTasks > 0)
+    {
+        if (!TryRunTask(workerIndex))
+        {
+            // Nothing left to steal, the remaining tasks of the group are running on other workers
+            // Sleep until one of them finishes the group or spawns a new task that can be executed meanwhile
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            sleepCondition.wait(lock, [&]() { return (group.pendingTasks == 0) || (queuedTasks > 0); });
+        }
+    }
+}
+
+void PointCloudEngine::TaskScheduler::ParallelFor(const size_t &count, std::function<void(const int &chunk, const size_t &begin, const size_t &end)> function)
+{
+    TaskGroup chunkTasks;
+
+    for (int chunk = 0; chunk < threadCount; chunk++)
+    {
+        size_t begin = (chunk * count) / threadCount;
+        size_t end = ((chunk + 1) * count) / threadCount;
+
+        Spawn(chunkTasks, [=]() { function(chunk, begin, end); });
+    }
+
+    Wait(chunkTasks);
+}
+
+int PointCloudEngine::TaskScheduler::GetThreadCount()
+{
+    return threadCount;
+}
+
+void PointCloudEngine::TaskScheduler::WorkerLoop(int workerIndex)
+{
+    currentScheduler = this;
+    currentWorkerIndex = workerIndex;
+
+    while (true)
+    {
+        if (!TryRunTask(workerIndex))
+        {
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            sleepCondition.wait(lock, [this]() { return !running || (queuedTasks > 0); });
+
+            if (!running)
+            {
+                return;
+            }
+        }
+    }
+}
+
+bool PointCloudEngine::TaskScheduler::TryRunTask(int workerIndex)
+{
+    Task task;
+    bool found = false;
+
+    // Try to pop the newest task from the own queue first
+    {
+        TaskQueue *queue = queues[workerIndex];
+        std::lock_guard<std::mutex> lock(queue->mutex);
+
+        if (!queue->tasks.empty())
+        {
+            task = queue->tasks.back();
+            queue->tasks.pop_back();
+            found = true;
+        }
+    }
+
+    // Steal the oldest task from the other queues
+    for (int i = 1; !found && (i < threadCount); i++)
+    {
+        TaskQueue *queue = queues[(workerIndex + i) % threadCount];
+        std::lock_guard<std::mutex> lock(queue->mutex);
+
+        if (!queue->tasks.empty())
+        {
+            task = queue->tasks.front();
+            queue->tasks.pop_front();
+            found = true;
+        }
+    }
+
+    if (found)
+    {
+        queuedTasks--;
+        task.function();
+
+        // The group can be destroyed by the waiting thread right after the last task finished, don't access it afterwards
+        if (--task.group->pendingTasks == 0)
+        {
+            // Lock the mutex before notifying to make sure that a thread that is about to wait doesn't miss the finished group
+            {
+                std::lock_guard<std::mutex> lock(sleepMutex);
+            }
+
+            sleepCondition.notify_all();
+        }
+    }
+
+    return found;
+}
+
+int PointCloudEngine::TaskScheduler::GetWorkerIndex()
+{
+    return (currentScheduler == this) ? currentWorkerIndex : 0;
+}
@@ -0,0 +1,63 @@
+#ifndef TASKSCHEDULER_H
+#define TASKSCHEDULER_H
+
+#pragma once
+#include "PointCloudEngine.h"
+
+namespace PointCloudEngine
+{
+    // Counts the tasks of a group that have not finished yet, used to wait for all of them
+    struct TaskGroup
+    {
+        std::atomic<int> pendingTasks{ 0 };
+    };
+
+    // Work stealing task scheduler with one task queue per worker
+    // Workers execute the newest task of their own queue first (depth first, cache friendly)
+    // When a worker runs out of tasks it steals the oldest task from another queue (usually the largest piece of work)
+    // The thread that creates the scheduler is worker 0 and helps executing tasks while waiting for a group
+    class TaskScheduler
+    {
+    public:
+        // A thread count of 0 uses all hardware threads
+        TaskScheduler(const int &threadCount);
+        ~TaskScheduler();
+
+        void Spawn(TaskGroup &group, std::function<void()> task);
+        void Wait(TaskGroup &group);
+
+        // Splits [0, count) into one consecutive chunk per thread and executes the function for all of them in parallel
+        void ParallelFor(const size_t &count, std::function<void(const int &chunk, const size_t &begin, const size_t &end)> function);
+        int GetThreadCount();
+
+        // Index of the calling worker in [0, GetThreadCount()), threads that don't belong to the scheduler get index 0
+        int GetWorkerIndex();
+
+    private:
+        struct Task
+        {
+            TaskGroup *group;
+            std::function<void()> function;
+        };
+
+        struct TaskQueue
+        {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        void WorkerLoop(int workerIndex);
+        bool TryRunTask(int workerIndex);
+
+        int threadCount = 1;
+        std::vector<std::thread> threads;
+        std::vector<TaskQueue*> queues;
+
+        // Workers sleep while there are no queued tasks, waiting threads also sleep until their group is finished
+        bool running = true;
+        std::atomic<int> queuedTasks{ 0 };
+        std::mutex sleepMutex;
+        std::condition_variable sleepCondition;
+    };
+}
+#endif
@@ -0,0 +1,81 @@
+#include "ViewFrustum.h"
+
+PointCloudEngine::ViewFrustum::ViewFrustum()
+{
+}
+
+PointCloudEngine::ViewFrustum::ViewFrustum(const Matrix &worldViewProjection)
+{
+    // The clip space position is the row vector times the matrix, each plane is a sum or difference of the matrix columns
+    // The clip space of Direct3D has 0 <= z <= w, the near plane is only the z column
+    const Matrix &m = worldViewProjection;
+    Vector4 columns[4] =
+    {
+        Vector4(m._11, m._21, m._31, m._41),
+        Vector4(m._12, m._22, m._32, m._42),
+        Vector4(m._13, m._23, m._33, m._43),
+        Vector4(m._14, m._24, m._34, m._44)
+    };
+
+    Vector4 planes[6] =
+    {
+        columns[3] + columns[0],
+        columns[3] - columns[0],
+        columns[3] + columns[1],
+        columns[3] - columns[1],
+        columns[2],
+        columns[3] - columns[2]
+    };
+
+    // The planes don't have to be normalized since the distance and the extent are scaled by the same length
+    planeCount = 6;
+
+    for (int i = 0; i < planeCount; i++)
+    {
+        x[i] = planes[i].x;
+        y[i] = planes[i].y;
+        z[i] = planes[i].z;
+        w[i] = planes[i].w;
+        extent[i] = std::abs(x[i]) + std::abs(y[i]) + std::abs(z[i]);
+    }
+}
+
+void PointCloudEngine::ViewFrustum::TestCubes(const Vector3 *centers, const int &count, const float &size, int &outOutsideMask, int &outInsideMask) const
+{
+    outOutsideMask = 0;
+    outInsideMask = 0;
+
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 halfSize = _mm_set1_ps(0.5f * size);
+
+    for (int i = 0; i < count; i += 4)
+    {
+        // The last batch is filled up by repeating its last valid cube, the bits of these repeated cubes are masked out
+        int batchCount = min(4, count - i);
+        int batchMask = (1 << batchCount) - 1;
+        const Vector3 &c0 = centers[i];
+        const Vector3 &c1 = centers[i + min(1, batchCount - 1)];
+        const Vector3 &c2 = centers[i + min(2, batchCount - 1)];
+        const Vector3 &c3 = centers[i + min(3, batchCount - 1)];
+
+        __m128 cx = _mm_setr_ps(c0.x, c1.x, c2.x, c3.x);
+        __m128 cy = _mm_setr_ps(c0.y, c1.y, c2.y, c3.y);
+        __m128 cz = _mm_setr_ps(c0.z, c1.z, c2.z, c3.z);
+
+        __m128 outside = zero;
+        __m128 inside = _mm_cmpeq_ps(zero, zero);
+
+        for (int j = 0; j < planeCount; j++)
+        {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(x[j])), _mm_mul_ps(cy, _mm_set1_ps(y[j]))), _mm_add_ps(_mm_mul_ps(cz, _mm_set1_ps(z[j])), _mm_set1_ps(w[j])));
+            __m128 radius = _mm_mul_ps(halfSize, _mm_set1_ps(extent[j]));
+
+            // Outside if even the corner furthest along the plane normal is behind the plane, inside if even the closest corner is in front of it
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_sub_ps(zero, radius)));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, radius));
+        }
+
+        outOutsideMask |= (_mm_movemask_ps(outside) & batchMask) << i;
+        outInsideMask |= (_mm_movemask_ps(inside) & batchMask) << i;
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef VIEWFRUSTUM_H
+#define VIEWFRUSTUM_H
+
+#pragma once
+#include "PointCloudEngine.h"
+
+namespace PointCloudEngine
+{
+    // The 6 planes of the view frustum in the local space of an object, the octree traversal culls the node cubes against them
+    class ViewFrustum
+    {
+    public:
+        // Contains everything, the traversal doesn't cull any nodes with it
+        ViewFrustum();
+
+        // Extracts the planes from the world * view * projection matrix, the planes are in the space that the world matrix transforms from
+        ViewFrustum(const Matrix &worldViewProjection);
+
+        // Tests up to 8 cubes with the same size against all the planes, 4 cubes at a time with SSE
+        // Bit i of the outside mask is set if cube i is completely outside of one plane, bit i of the inside mask if it is inside of all the planes
+        // Cubes that intersect a plane have neither bit set, they and their children have to be tested again
+        void TestCubes(const Vector3 *centers, const int &count, const float &size, int &outOutsideMask, int &outInsideMask) const;
+
+    private:
+        // Structure of arrays, a point p is inside of plane i if x[i] * p.x + y[i] * p.y + z[i] * p.z + w[i] >= 0
+        // The extent is |x[i]| + |y[i]| + |z[i]|, multiplied with half the cube size this is the largest distance from the center to a corner along the plane normal
+        int planeCount = 0;
+        float x[6], y[6], z[6], w[6], extent[6];
+    };
+}
+#endif